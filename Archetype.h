@@ -0,0 +1,775 @@
+#pragma once
+#include "Ecs.h"
+#include <array>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ecs
+{
+	namespace detail
+	{
+		// What an archetype column needs to know about the type it stores
+		struct ColumnType
+		{
+			size_t size;
+			size_t alignment;
+			// Move constructs aCount elements into aDestination and destroys the sources
+			void (*relocate)(void* aDestination, void* aSource, size_t aCount);
+			void (*destroy)(void* someData, size_t aCount);
+
+			template <typename T>
+			static const ColumnType& Of()
+			{
+				static const ColumnType type = { sizeof(T), alignof(T), &Relocate<T>, &Destroy<T> };
+				return type;
+			}
+
+		private:
+			template <typename T>
+			static void Relocate(void* aDestination, void* aSource, size_t aCount)
+			{
+				if constexpr (std::is_trivially_copyable_v<T>)
+					std::memcpy(aDestination, aSource, aCount * sizeof(T));
+				else
+				{
+					T* destination = static_cast<T*>(aDestination);
+					T* source = static_cast<T*>(aSource);
+					for (size_t i = 0; i < aCount; ++i)
+					{
+						new (destination + i) T(std::move(source[i]));
+						source[i].~T();
+					}
+				}
+			}
+
+			template <typename T>
+			static void Destroy(void* someData, size_t aCount)
+			{
+				if constexpr (!std::is_trivially_destructible_v<T>)
+				{
+					T* data = static_cast<T*>(someData);
+					for (size_t i = 0; i < aCount; ++i)
+						data[i].~T();
+				}
+			}
+		};
+
+		// Untyped array of components, the archetype keeps track of how many are constructed
+		class Column
+		{
+		public:
+			Column(const ColumnType& aType, Entity aBit) : myType(&aType), myBit(aBit), myData(nullptr)
+			{}
+
+			Column(Column&& aColumn) noexcept : myType(aColumn.myType), myBit(aColumn.myBit), myData(aColumn.myData)
+			{
+				aColumn.myData = nullptr;
+			}
+
+			Column(const Column&) = delete;
+			Column& operator=(const Column&) = delete;
+
+			~Column()
+			{
+				if (myData)
+					::operator delete(myData, std::align_val_t(myType->alignment));
+			}
+
+			void* Data()
+			{
+				return myData;
+			}
+
+			const void* Data() const
+			{
+				return myData;
+			}
+
+			void* At(size_t aRow)
+			{
+				return static_cast<std::byte*>(myData) + aRow * myType->size;
+			}
+
+			void Relocate(size_t aCount, size_t aCapacity)
+			{
+				void* data = ::operator new(aCapacity * myType->size, std::align_val_t(myType->alignment));
+				if (myData)
+				{
+					myType->relocate(data, myData, aCount);
+					::operator delete(myData, std::align_val_t(myType->alignment));
+				}
+				myData = data;
+			}
+
+			const ColumnType& Type() const
+			{
+				return *myType;
+			}
+
+			Entity Bit() const
+			{
+				return myBit;
+			}
+
+		private:
+			const ColumnType* myType;
+			Entity myBit;
+			void* myData;
+		};
+	}
+
+	// Every entity with exactly the same set of components lives in the same archetype, one column per component.
+	// Rows are packed, so iterating an archetype is a linear walk over its columns
+	class Archetype
+	{
+	public:
+		static constexpr size_t npos = size_t(-1);
+
+		Archetype(const Signature& aSignature, const std::vector<const detail::ColumnType*>& someTypes) :
+			mySignature(aSignature), myColumnOf(Signature::Bits, npos), myCapacity(0)
+		{
+			aSignature.Each([this, &someTypes](Entity aBit)
+			{
+				myColumnOf[aBit] = myColumns.size();
+				myColumns.emplace_back(*someTypes[aBit], aBit);
+			});
+		}
+
+		~Archetype()
+		{
+			for (detail::Column& column : myColumns)
+				column.Type().destroy(column.Data(), Size());
+		}
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		const Signature& GetSignature() const
+		{
+			return mySignature;
+		}
+
+		size_t Size() const
+		{
+			return myEntities.size();
+		}
+
+		const Entity* Entities() const
+		{
+			return myEntities.data();
+		}
+
+		bool Has(Entity aBit) const
+		{
+			return myColumnOf[aBit] != npos;
+		}
+
+		detail::Column& ColumnOf(Entity aBit)
+		{
+			ECS_ASSERT(Has(aBit));
+			return myColumns[myColumnOf[aBit]];
+		}
+
+		const detail::Column& ColumnOf(Entity aBit) const
+		{
+			ECS_ASSERT(Has(aBit));
+			return myColumns[myColumnOf[aBit]];
+		}
+
+		template <typename T>
+		T* Data(Entity aBit)
+		{
+			return static_cast<T*>(ColumnOf(aBit).Data());
+		}
+
+		template <typename T>
+		const T* Data(Entity aBit) const
+		{
+			return static_cast<const T*>(ColumnOf(aBit).Data());
+		}
+
+		std::vector<detail::Column>& Columns()
+		{
+			return myColumns;
+		}
+
+		// Appends a row for aEntity. Its components are constructed by the caller
+		Entity Push(Entity aEntity)
+		{
+			if (Size() == myCapacity)
+				Reserve((std::max)(myCapacity * 2, size_t(16)));
+
+			myEntities.push_back(aEntity);
+			return static_cast<Entity>(Size() - 1);
+		}
+
+		void Reserve(size_t aCapacity)
+		{
+			if (aCapacity <= myCapacity)
+				return;
+
+			for (detail::Column& column : myColumns)
+				column.Relocate(Size(), aCapacity);
+			myEntities.reserve(aCapacity);
+			myCapacity = aCapacity;
+		}
+
+		// Closes the gap at aRow, whose components have already been moved out or destroyed, with the last row.
+		// Returns the entity that moved into aRow, or nullentity if aRow was the last row
+		Entity Fill(Entity aRow)
+		{
+			const Entity last = static_cast<Entity>(Size() - 1);
+			Entity moved = nullentity;
+			if (aRow != last)
+			{
+				for (detail::Column& column : myColumns)
+					column.Type().relocate(column.At(aRow), column.At(last), 1);
+				moved = myEntities[aRow] = myEntities[last];
+			}
+			myEntities.pop_back();
+			return moved;
+		}
+
+		// Cached target of adding or removing a component, npos until the transition is first made
+		size_t& Edge(Entity aBit, bool anAdd)
+		{
+			for (EdgeEntry& edge : myEdges)
+			{
+				if (edge.bit == aBit)
+					return anAdd ? edge.add : edge.remove;
+			}
+			myEdges.push_back({ aBit, npos, npos });
+			return anAdd ? myEdges.back().add : myEdges.back().remove;
+		}
+
+	private:
+		struct EdgeEntry
+		{
+			Entity bit;
+			size_t add;
+			size_t remove;
+		};
+
+		Signature mySignature;
+		std::vector<size_t> myColumnOf;
+		std::vector<detail::Column> myColumns;
+		std::vector<Entity> myEntities;
+		std::vector<EdgeEntry> myEdges;
+		size_t myCapacity;
+	};
+
+	// Archetypes matching a view. Archetypes are never removed, so matching only has to look at the ones created since
+	class ArchetypeQuery
+	{
+	public:
+		ArchetypeQuery(const Signature& anInclude, const Signature& anExclude, const std::vector<std::unique_ptr<Archetype>>& someArchetypes) :
+			myInclude(anInclude), myExclude(anExclude), myArchetypes(&someArchetypes), myChecked(0)
+		{}
+
+		bool Is(const Signature& anInclude, const Signature& anExclude) const
+		{
+			return myInclude == anInclude && myExclude == anExclude;
+		}
+
+		const std::vector<Archetype*>& Matches()
+		{
+			for (; myChecked < myArchetypes->size(); ++myChecked)
+			{
+				Archetype* archetype = (*myArchetypes)[myChecked].get();
+				if (archetype->GetSignature().Matches(myInclude, myExclude))
+					myMatches.push_back(archetype);
+			}
+			return myMatches;
+		}
+
+	private:
+		Signature myInclude;
+		Signature myExclude;
+		const std::vector<std::unique_ptr<Archetype>>* myArchetypes;
+		std::vector<Archetype*> myMatches;
+		size_t myChecked;
+	};
+
+	// Walks the rows of the matching archetypes one after another and skips the empty ones. The columns of the
+	// current archetype are looked up once when it is entered, not per row
+	template <typename... Types>
+	class ArchetypeViewIterator
+	{
+	public:
+		using ValueType = Entity;
+
+		ArchetypeViewIterator(const std::vector<Archetype*>& someArchetypes, size_t anArchetype, const std::array<Entity, sizeof...(Types)>& someBits) :
+			archetypes(&someArchetypes), archetype(anArchetype), row(0), bits(someBits)
+		{
+			Enter();
+		}
+
+		Entity operator*() const
+		{
+			return entities[row];
+		}
+
+		bool operator!=(const ArchetypeViewIterator& aRhs) const
+		{
+			return archetype != aRhs.archetype || row != aRhs.row;
+		}
+
+		bool operator==(const ArchetypeViewIterator& aRhs) const
+		{
+			return !(*this != aRhs);
+		}
+
+		ArchetypeViewIterator& operator++()
+		{
+			if (++row == size)
+			{
+				++archetype;
+				row = 0;
+				Enter();
+			}
+			return *this;
+		}
+
+		ArchetypeViewIterator operator++(int)
+		{
+			ArchetypeViewIterator tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+		std::tuple<Entity, Types&...> Components() const
+		{
+			return Components(std::index_sequence_for<Types...>{});
+		}
+
+	private:
+		template <size_t... I>
+		std::tuple<Entity, Types&...> Components(std::index_sequence<I...>) const
+		{
+			return std::tuple<Entity, Types&...>(entities[row], std::get<I>(columns)[row]...);
+		}
+
+		template <size_t... I>
+		void Load(Archetype& anArchetype, std::index_sequence<I...>)
+		{
+			columns = std::tuple<Types*...>(anArchetype.template Data<Types>(bits[I])...);
+		}
+
+		void Enter()
+		{
+			for (; archetype < archetypes->size(); ++archetype)
+			{
+				Archetype& current = *(*archetypes)[archetype];
+				if (current.Size() == 0)
+					continue;
+
+				entities = current.Entities();
+				size = current.Size();
+				Load(current, std::index_sequence_for<Types...>{});
+				return;
+			}
+			archetype = archetypes->size();
+			entities = nullptr;
+			size = 0;
+		}
+
+		const std::vector<Archetype*>* archetypes;
+		size_t archetype;
+		size_t row;
+		size_t size;
+		const Entity* entities;
+		std::tuple<Types*...> columns;
+		std::array<Entity, sizeof...(Types)> bits;
+	};
+
+	template <typename... Types>
+	class ArchetypeViewEachIterator
+	{
+	private:
+		using IteratorType = ArchetypeViewIterator<Types...>;
+	public:
+		ArchetypeViewEachIterator(IteratorType&& aIterator) : it(std::move(aIterator))
+		{}
+
+		std::tuple<Entity, Types&...> operator*() const
+		{
+			return it.Components();
+		}
+
+		bool operator!=(const ArchetypeViewEachIterator& aRhs) const
+		{
+			return it != aRhs.it;
+		}
+
+		bool operator==(const ArchetypeViewEachIterator& aRhs) const
+		{
+			return it == aRhs.it;
+		}
+
+		ArchetypeViewEachIterator& operator++()
+		{
+			++it;
+			return *this;
+		}
+
+		ArchetypeViewEachIterator operator++(int)
+		{
+			ArchetypeViewEachIterator tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+	private:
+		IteratorType it;
+	};
+
+	template <typename, typename>
+	class ArchetypeView;
+
+	template <typename... Types, typename... Excludes>
+	class ArchetypeView<TList<Types...>, TList<Excludes...>>
+	{
+	public:
+		using Iterator = ArchetypeViewIterator<Types...>;
+		using EachIterator = ArchetypeViewEachIterator<Types...>;
+		using EachIteratorWrapper = IIterator<EachIterator>;
+	public:
+		ArchetypeView(ArchetypeQuery& aQuery, const std::array<Entity, sizeof...(Types)>& someBits) :
+			query(&aQuery), bits(someBits)
+		{}
+
+		// Archetypes created while iterating are visited if they come after the current one
+		Iterator begin()
+		{
+			return Iterator(query->Matches(), 0, bits);
+		}
+
+		Iterator end()
+		{
+			const std::vector<Archetype*>& matches = query->Matches();
+			return Iterator(matches, matches.size(), bits);
+		}
+
+		EachIteratorWrapper Each()
+		{
+			return EachIteratorWrapper(EachIterator(begin()), EachIterator(end()));
+		}
+
+		// Calls aFunction(entity, components...) for every entity in the view, one archetype after another
+		template <typename Func>
+		void Each(Func&& aFunction)
+		{
+			for (Archetype* archetype : query->Matches())
+				EachIn(*archetype, aFunction, std::index_sequence_for<Types...>{});
+		}
+
+		size_t Size()
+		{
+			size_t size = 0;
+			for (Archetype* archetype : query->Matches())
+				size += archetype->Size();
+			return size;
+		}
+
+	private:
+		template <typename Func, size_t... I>
+		void EachIn(Archetype& anArchetype, Func& aFunction, std::index_sequence<I...>)
+		{
+			const Entity* entities = anArchetype.Entities();
+			const std::tuple<Types*...> columns(anArchetype.template Data<Types>(bits[I])...);
+			for (size_t row = 0, size = anArchetype.Size(); row < size; ++row)
+				aFunction(entities[row], std::get<I>(columns)[row]...);
+		}
+
+		ArchetypeQuery* query;
+		std::array<Entity, sizeof...(Types)> bits;
+	};
+
+	// Registry that stores components in archetype tables instead of one sparse set per type. Iterating several
+	// components is a linear walk without membership tests, while adding and removing components moves the entity
+	// to another archetype. Suits data whose component sets rarely change. Hooks, groups and timed destroys
+	// are only available on Registry.
+	class ArchetypeRegistry
+	{
+	public:
+		ArchetypeRegistry()
+		{
+			Clear();
+		}
+
+		void Clear()
+		{
+			myQueries.clear();
+			myArchetypes.clear();
+			myEntities.clear();
+			myLocations.clear();
+			myFreeList = EntityTraits::IndexMask;
+			myBits.clear();
+			myColumnTypes.clear();
+
+			// Entities without components live in the empty archetype
+			myArchetypes.emplace_back(new Archetype(Signature{}, myColumnTypes));
+		}
+
+		Entity Create()
+		{
+			Entity entity;
+			if (myFreeList != EntityTraits::IndexMask)
+			{
+				const Entity index = myFreeList;
+				myFreeList = EntityTraits::Index(myEntities[index]);
+				entity = myEntities[index] = EntityTraits::Combine(index, EntityTraits::Version(myEntities[index]));
+			}
+			else
+			{
+				ECS_ASSERT(myEntities.size() < EntityTraits::IndexMask && "Out of entity indices");
+				entity = EntityTraits::Combine(static_cast<Entity>(myEntities.size()), 0);
+				myEntities.push_back(entity);
+				myLocations.emplace_back();
+			}
+
+			myLocations[EntityTraits::Index(entity)] = { 0, myArchetypes[0]->Push(entity) };
+			return entity;
+		}
+
+		template <typename It>
+		void Create(It aFirst, It aLast)
+		{
+			for (; aFirst != aLast; ++aFirst)
+				*aFirst = Create();
+		}
+
+		void Destroy(Entity aEntity)
+		{
+			ECS_ASSERT_VALID_ENTITY(Alive(aEntity) && "Destroying invalid entity");
+			const Entity index = EntityTraits::Index(aEntity);
+			const Location location = myLocations[index];
+			Archetype& archetype = *myArchetypes[location.archetype];
+			for (detail::Column& column : archetype.Columns())
+				column.Type().destroy(column.At(location.row), 1);
+			Moved(archetype.Fill(location.row), location.row);
+
+			myEntities[index] = EntityTraits::Combine(myFreeList, EntityTraits::NextVersion(aEntity));
+			myFreeList = index;
+		}
+
+		bool Alive(Entity aEntity) const
+		{
+			const Entity index = EntityTraits::Index(aEntity);
+			return index < myEntities.size() && myEntities[index] == aEntity;
+		}
+
+		bool Valid(Entity aEntity) const
+		{
+			return Alive(aEntity);
+		}
+
+		template <typename T, typename... Args>
+		T& Emplace(Entity aEntity, Args&&... args)
+		{
+			ECS_ASSERT_VALID_ENTITY(Alive(aEntity));
+			ECS_ASSERT(!Contains<T>(aEntity) && "Entity already has such a component");
+
+			const Entity bit = BitOf<T>();
+			const Location location = Move(aEntity, Transition(myLocations[EntityTraits::Index(aEntity)].archetype, bit, true));
+			T* component = myArchetypes[location.archetype]->template Data<T>(bit) + location.row;
+			if constexpr (std::is_aggregate_v<T>)
+				return *new (component) T{ std::forward<Args>(args)... };
+			else
+				return *new (component) T(std::forward<Args>(args)...);
+		}
+
+		template <typename T, typename... Args>
+		T& EmplaceOrReplace(Entity aEntity, Args&&... args)
+		{
+			if (!Contains<T>(aEntity))
+				return Emplace<T>(aEntity, std::forward<Args>(args)...);
+
+			T& component = Get<T>(aEntity);
+			if constexpr (std::is_aggregate_v<T>)
+				component = T{ std::forward<Args>(args)... };
+			else
+				component = T(std::forward<Args>(args)...);
+			return component;
+		}
+
+		template <typename T>
+		void Remove(Entity aEntity)
+		{
+			ECS_ASSERT(Contains<T>(aEntity) && "Entity has no such component");
+			const Entity bit = BitOf<T>();
+			const Location location = myLocations[EntityTraits::Index(aEntity)];
+			Move(aEntity, Transition(location.archetype, bit, false));
+		}
+
+		template <typename T>
+		bool Contains(Entity aEntity) const
+		{
+			ECS_ASSERT_VALID_ENTITY(Alive(aEntity));
+			const Entity bit = FindBit<T>();
+			return bit != Signature::NoBit && myArchetypes[myLocations[EntityTraits::Index(aEntity)].archetype]->Has(bit);
+		}
+
+		template <typename T>
+		T& Get(Entity aEntity)
+		{
+			ECS_ASSERT(Contains<T>(aEntity) && "Entity has no such component");
+			const Location location = myLocations[EntityTraits::Index(aEntity)];
+			return myArchetypes[location.archetype]->template Data<T>(FindBit<T>())[location.row];
+		}
+
+		template <typename T>
+		const T& Get(Entity aEntity) const
+		{
+			ECS_ASSERT(Contains<T>(aEntity) && "Entity has no such component");
+			const Location location = myLocations[EntityTraits::Index(aEntity)];
+			return myArchetypes[location.archetype]->template Data<T>(FindBit<T>())[location.row];
+		}
+
+		template <typename T>
+		T* TryGet(Entity aEntity)
+		{
+			return Contains<T>(aEntity) ? &Get<T>(aEntity) : nullptr;
+		}
+
+		template <typename T>
+		const T* TryGet(Entity aEntity) const
+		{
+			return Contains<T>(aEntity) ? &Get<T>(aEntity) : nullptr;
+		}
+
+		// Views stay valid and pick up new archetypes until the registry is cleared
+		template <typename T1, typename... Types>
+		ArchetypeView<TList<T1, Types...>, TList<>> View()
+		{
+			return View<T1, Types...>(ecs::Exclude<>());
+		}
+
+		template <typename T1, typename... Types, typename... Excludes>
+		ArchetypeView<TList<T1, Types...>, TList<Excludes...>> View(ecs::Exclude<Excludes...>)
+		{
+			const std::array<Entity, sizeof...(Types) + 1> bits = { BitOf<T1>(), BitOf<Types>()... };
+			Signature include;
+			for (Entity bit : bits)
+				include.Set(bit);
+			Signature exclude;
+			(exclude.Set(BitOf<Excludes>()), ...);
+
+			return { Query(include, exclude), bits };
+		}
+
+		size_t ArchetypeCount() const
+		{
+			return myArchetypes.size();
+		}
+
+	private:
+		struct Location
+		{
+			Entity archetype;
+			Entity row;
+		};
+
+		template <typename T>
+		Entity FindBit() const
+		{
+			const Entity type = TypeID::Type<T>();
+			return type < myBits.size() ? myBits[type] : Signature::NoBit;
+		}
+
+		// Bits are handed out per registry, in the order component types are first used
+		template <typename T>
+		Entity BitOf()
+		{
+			const Entity type = TypeID::Type<T>();
+			if (type >= myBits.size())
+				myBits.resize(type + 1, Signature::NoBit);
+			if (myBits[type] == Signature::NoBit)
+			{
+				ECS_ASSERT(myColumnTypes.size() < Signature::Bits && "More component types than ECS_SIGNATURE_BITS");
+				myBits[type] = static_cast<Entity>(myColumnTypes.size());
+				myColumnTypes.push_back(&detail::ColumnType::Of<T>());
+			}
+			return myBits[type];
+		}
+
+		// Archetype reached by adding or removing aBit, created the first time it is needed
+		Entity Transition(Entity anArchetype, Entity aBit, bool anAdd)
+		{
+			size_t& edge = myArchetypes[anArchetype]->Edge(aBit, anAdd);
+			if (edge != Archetype::npos)
+				return static_cast<Entity>(edge);
+
+			Signature signature = myArchetypes[anArchetype]->GetSignature();
+			if (anAdd)
+				signature.Set(aBit);
+			else
+				signature.Reset(aBit);
+
+			size_t target = 0;
+			while (target < myArchetypes.size() && !(myArchetypes[target]->GetSignature() == signature))
+				++target;
+			if (target == myArchetypes.size())
+				myArchetypes.emplace_back(new Archetype(signature, myColumnTypes));
+
+			edge = target;
+			myArchetypes[target]->Edge(aBit, !anAdd) = anArchetype;
+			return static_cast<Entity>(target);
+		}
+
+		// Moves the components aEntity shares with the target archetype over and destroys the rest.
+		// Components only the target has are left for the caller to construct
+		Location Move(Entity aEntity, Entity aTarget)
+		{
+			const Entity index = EntityTraits::Index(aEntity);
+			const Location from = myLocations[index];
+			Archetype& source = *myArchetypes[from.archetype];
+			Archetype& target = *myArchetypes[aTarget];
+
+			const Location to = { aTarget, target.Push(aEntity) };
+			for (detail::Column& column : source.Columns())
+			{
+				const Entity bit = column.Bit();
+				if (target.Has(bit))
+					column.Type().relocate(target.ColumnOf(bit).At(to.row), column.At(from.row), 1);
+				else
+					column.Type().destroy(column.At(from.row), 1);
+			}
+			Moved(source.Fill(from.row), from.row);
+
+			myLocations[index] = to;
+			return to;
+		}
+
+		void Moved(Entity aEntity, Entity aRow)
+		{
+			if (aEntity != nullentity)
+				myLocations[EntityTraits::Index(aEntity)].row = aRow;
+		}
+
+		ArchetypeQuery& Query(const Signature& anInclude, const Signature& anExclude)
+		{
+			for (std::unique_ptr<ArchetypeQuery>& query : myQueries)
+			{
+				if (query->Is(anInclude, anExclude))
+					return *query;
+			}
+			myQueries.emplace_back(new ArchetypeQuery(anInclude, anExclude, myArchetypes));
+			return *myQueries.back();
+		}
+
+		std::vector<Entity> myEntities;
+		std::vector<Location> myLocations;
+		Entity myFreeList = EntityTraits::IndexMask;
+
+		std::vector<Entity> myBits;
+		std::vector<const detail::ColumnType*> myColumnTypes;
+		std::vector<std::unique_ptr<Archetype>> myArchetypes;
+		std::vector<std::unique_ptr<ArchetypeQuery>> myQueries;
+	};
+}
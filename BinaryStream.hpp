@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace mys
+{
+	// Appends everything written to a byte buffer
+	class BinaryWriter
+	{
+	public:
+		void Write(const void* someData, size_t aSize)
+		{
+			const char* bytes = static_cast<const char*>(someData);
+			myBuffer.insert(myBuffer.end(), bytes, bytes + aSize);
+		}
+
+		const std::vector<char>& Buffer() const
+		{
+			return myBuffer;
+		}
+
+		std::vector<char>& Buffer()
+		{
+			return myBuffer;
+		}
+
+	private:
+		std::vector<char> myBuffer;
+	};
+
+	// Hashes everything written to it without keeping it. The hash only depends on the bytes, not on how they were
+	// split over calls to Write
+	class HashWriter
+	{
+	public:
+		void Write(const void* someData, size_t aSize)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(someData);
+			myLength += aSize;
+			while (aSize && myPendingCount)
+			{
+				Push(*bytes++);
+				--aSize;
+			}
+			for (; aSize >= sizeof(uint64_t); aSize -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+				Mix(bytes);
+			while (aSize--)
+				Push(*bytes++);
+		}
+
+		uint64_t Hash() const
+		{
+			HashWriter tail = *this;
+			while (tail.myPendingCount)
+				tail.Push(0);
+			return (tail.myHash ^ (tail.myHash >> 32) ^ myLength) * Multiplier;
+		}
+
+	private:
+		static constexpr uint64_t Multiplier = 0x9E3779B97F4A7C15ull;
+
+		void Push(unsigned char aByte)
+		{
+			myPending[myPendingCount++] = aByte;
+			if (myPendingCount == sizeof(myPending))
+			{
+				myPendingCount = 0;
+				Mix(myPending);
+			}
+		}
+
+		void Mix(const unsigned char* someBytes)
+		{
+			uint64_t word;
+			std::memcpy(&word, someBytes, sizeof(word));
+			myHash = (myHash ^ word) * Multiplier;
+			myHash ^= myHash >> 29;
+		}
+
+		uint64_t myHash = 0xCBF29CE484222325ull;
+		uint64_t myLength = 0;
+		unsigned char myPending[sizeof(uint64_t)] = {};
+		size_t myPendingCount = 0;
+	};
+
+	// Reads from a byte range it doesn't own. Reading past the end yields zeroes and marks the reader as failed
+	class BinaryReader
+	{
+	public:
+		BinaryReader(const void* someData, size_t aSize) : myData(static_cast<const char*>(someData)), mySize(aSize), myPosition(0), myFailed(false)
+		{}
+
+		void Read(void* someData, size_t aSize)
+		{
+			const size_t available = (std::min)(aSize, mySize - myPosition);
+			if (available)
+				std::memcpy(someData, myData + myPosition, available);
+			if (available < aSize)
+			{
+				std::memset(static_cast<char*>(someData) + available, 0, aSize - available);
+				myFailed = true;
+			}
+			myPosition += available;
+		}
+
+		size_t Position() const
+		{
+			return myPosition;
+		}
+
+		bool Failed() const
+		{
+			return myFailed;
+		}
+
+	private:
+		const char* myData;
+		size_t mySize;
+		size_t myPosition;
+		bool myFailed;
+	};
+}
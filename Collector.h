@@ -0,0 +1,153 @@
+#pragma once
+#include "Ecs.h"
+#include <cstddef>
+
+namespace ecs
+{
+	// The entity got a T
+	template <typename T>
+	struct Constructed
+	{};
+
+	// The T of the entity was changed through Patch, Replace or ApplyDelta
+	template <typename T>
+	struct Updated
+	{};
+
+	// The entity lost its T, also by being destroyed
+	template <typename T>
+	struct Destroyed
+	{};
+
+	namespace detail
+	{
+		struct Collected
+		{};
+	}
+
+	// Records every entity one of the events happened to, each once, until Clear. Meant to be drained once per
+	// frame by a system that only cares about what is new:
+	//
+	//     ecs::Collector<ecs::Constructed<Collider>> newColliders(registry);
+	//     ...
+	//     newColliders.Each(registry.View<Collider, Transform>(ecs::Exclude<Static>()), [](ecs::Entity, Collider&, Transform&) { ... });
+	//     newColliders.Clear();
+	//
+	// It keeps collecting through Clear and Restore, which don't emit for the components they drop or load. A
+	// collector may outlive its registry, it is told when the registry goes and keeps what it recorded as long as
+	// the registry's memory resource lives, but Each can't be used anymore
+	template <typename... Events>
+	class Collector
+	{
+	public:
+		explicit Collector(Registry& aRegistry) : myRegistry(&aRegistry), myEntities(aRegistry.GetResource())
+		{
+			static_assert(sizeof...(Events) > 0, "A collector needs at least one event");
+			(Connect(Events{}), ...);
+			aRegistry.OnRelease(Listener::Bind<&Collector::Release>(*this));
+		}
+
+		Collector(const Collector&) = delete;
+		Collector& operator=(const Collector&) = delete;
+
+		~Collector()
+		{
+			if (!myRegistry)
+				return;
+			(Disconnect(Events{}), ...);
+			myRegistry->DisconnectRelease(Listener::Bind<&Collector::Release>(*this));
+		}
+
+		size_t Size() const
+		{
+			return myEntities.Size();
+		}
+
+		bool Empty() const
+		{
+			return myEntities.Size() == 0;
+		}
+
+		bool Contains(Entity aEntity) const
+		{
+			return myEntities.Contains(aEntity);
+		}
+
+		// Every recorded entity in the order they were first recorded, including ones destroyed since
+		const Entity* begin() const
+		{
+			return myEntities.DenseData();
+		}
+
+		const Entity* end() const
+		{
+			return myEntities.DenseData() + myEntities.Size();
+		}
+
+		// Calls aFunction(entity, components...) for the recorded entities that are still alive and in aView. Entities
+		// recorded while this runs are visited as well
+		template <typename View, typename Func>
+		void Each(View&& aView, Func&& aFunction)
+		{
+			ECS_ASSERT(myRegistry && "The registry is gone");
+			for (size_t i = 0; i < myEntities.Size(); ++i)
+			{
+				const Entity entity = myEntities.DenseData()[i];
+				if (myRegistry->Alive(entity) && aView.Contains(entity))
+					aView.Apply(entity, aFunction);
+			}
+		}
+
+		// Forgets the recorded entities but keeps the memory for the next frame
+		void Clear()
+		{
+			while (myEntities.Size())
+				myEntities.Remove(myEntities.DenseData()[myEntities.Size() - 1]);
+		}
+
+	private:
+		template <typename T>
+		void Connect(Constructed<T>)
+		{
+			myRegistry->OnConstruct<T>(Listener::Bind<&Collector::Record>(*this));
+		}
+
+		template <typename T>
+		void Connect(Updated<T>)
+		{
+			myRegistry->OnUpdate<T>(Listener::Bind<&Collector::Record>(*this));
+		}
+
+		template <typename T>
+		void Connect(Destroyed<T>)
+		{
+			myRegistry->OnDestroy<T>(Listener::Bind<&Collector::Record>(*this));
+		}
+
+		template <template <typename> typename Event, typename T>
+		void Disconnect(Event<T>)
+		{
+			myRegistry->Disconnect<T>(Listener::Bind<&Collector::Record>(*this));
+		}
+
+		// The registry's signals went with it
+		void Release(Entity)
+		{
+			myRegistry = nullptr;
+		}
+
+		// A destroyed entity may still be recorded when its index comes back with a new version, the old one is dropped
+		void Record(Entity aEntity)
+		{
+			const Entity occupant = myEntities.Occupant(aEntity);
+			if (occupant == aEntity)
+				return;
+			if (occupant != nullentity)
+				myEntities.Remove(occupant);
+			myEntities.Emplace(aEntity);
+		}
+
+		Registry* myRegistry;
+		SparseSet<detail::Collected> myEntities;
+	};
+}
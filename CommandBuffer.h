@@ -0,0 +1,408 @@
+#pragma once
+#include "Ecs.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ecs
+{
+	namespace detail
+	{
+		// The placeholder indices of every buffer in the process, handed out in chunks. A chunk belongs to one
+		// recording of one buffer until that buffer starts its next recording, so a placeholder is only ever
+		// accepted by the recording that made it
+		class PlaceholderChunks
+		{
+		public:
+			static constexpr Entity ChunkBits = EntityTraits::IndexBits / 2 < 8 ? EntityTraits::IndexBits / 2 : 8;
+			static constexpr Entity ChunkSize = Entity(1) << ChunkBits;
+			// The index of nullentity is left out
+			static constexpr Entity ChunkCount = EntityTraits::IndexMask >> ChunkBits;
+
+			// Recordings are numbered from 1 and never repeat, 0 marks a free chunk
+			static uint64_t NextRecording()
+			{
+				static std::atomic<uint64_t> recording{ 1 };
+				return recording++;
+			}
+
+			// Running out means more placeholders are waiting for playback than entity indices exist, which no
+			// playback could honor either, so this fails in release builds as well
+			static Entity Claim(uint64_t aRecording, Entity aPosition)
+			{
+				static std::atomic<Entity> next{ 0 };
+				for (Entity attempt = 0; attempt < ChunkCount; ++attempt)
+				{
+					const Entity chunk = next++ % ChunkCount;
+					uint64_t free = 0;
+					if (Owners()[chunk].recording.compare_exchange_strong(free, aRecording, std::memory_order_acq_rel))
+					{
+						Owners()[chunk].position.store(aPosition, std::memory_order_relaxed);
+						return chunk;
+					}
+				}
+				ECS_ASSERT(false && "Out of placeholder entities");
+				std::terminate();
+			}
+
+			static void Release(Entity aChunk)
+			{
+				Owners()[aChunk].recording.store(0, std::memory_order_release);
+			}
+
+			// Where the chunk comes in the recording's placeholders, or ChunkCount if it isn't the recording's
+			static Entity PositionIn(Entity aChunk, uint64_t aRecording)
+			{
+				if (aChunk >= ChunkCount || Owners()[aChunk].recording.load(std::memory_order_acquire) != aRecording)
+					return ChunkCount;
+				return Owners()[aChunk].position.load(std::memory_order_relaxed);
+			}
+
+		private:
+			struct Owner
+			{
+				std::atomic<uint64_t> recording{ 0 };
+				std::atomic<Entity> position{ 0 };
+			};
+
+			static Owner* Owners()
+			{
+				static const std::unique_ptr<Owner[]> owners(new Owner[ChunkCount]);
+				return owners.get();
+			}
+		};
+	}
+
+	// Records structural changes to be applied to a registry later, for example from worker threads or while a view
+	// is being iterated. A buffer is not thread safe, every thread records into its own (see CommandBuffers).
+	// Create hands out placeholders that are replaced by real entities during playback. A placeholder only means
+	// something to the buffer that made it, and only until that buffer starts recording after a playback. Placeholder
+	// indices are shared out between all buffers of the process and remember the recording they belong to, so
+	// placeholders handed to the wrong buffer or kept past their recording are caught rather than mapped to
+	// whatever that buffer created in the same slot.
+	class CommandBuffer
+	{
+	public:
+		CommandBuffer() : myRecording(detail::PlaceholderChunks::NextRecording())
+		{}
+
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+		~CommandBuffer()
+		{
+			Clear();
+			for (Entity chunk : myChunks)
+				detail::PlaceholderChunks::Release(chunk);
+		}
+
+		static bool IsPlaceholder(Entity aEntity)
+		{
+			return aEntity != nullentity && EntityTraits::Version(aEntity) == EntityTraits::ReservedVersion;
+		}
+
+		Entity Create()
+		{
+			BeginRecording();
+			const Entity slot = static_cast<Entity>(myCreated.size());
+			if ((slot & ChunkMask) == 0)
+				myChunks.push_back(detail::PlaceholderChunks::Claim(myRecording, static_cast<Entity>(myChunks.size())));
+			const Entity placeholder = EntityTraits::Combine((myChunks.back() << ChunkBits) | (slot & ChunkMask), EntityTraits::ReservedVersion);
+			myCreated.push_back(nullentity);
+			myCommands.push_back({ &ExecuteCreate, nullptr, placeholder, nullptr });
+			return placeholder;
+		}
+
+		// Applied as EmplaceOrReplace, so recording the same component twice keeps the last one
+		template <typename T, typename... Args>
+		void Emplace(Entity aEntity, Args&&... args)
+		{
+			ECS_ASSERT(aEntity != nullentity);
+			BeginRecording();
+			ECS_ASSERT(Owns(aEntity) && "Placeholder was made by another buffer or before the last playback");
+			T* component = Allocate<T>();
+			if constexpr (std::is_aggregate_v<T>)
+				new (component) T{ std::forward<Args>(args)... };
+			else
+				new (component) T(std::forward<Args>(args)...);
+
+			myCommands.push_back({ &ExecuteEmplace<T>, &Release<T>, aEntity, component });
+		}
+
+		template <typename T>
+		void Remove(Entity aEntity)
+		{
+			ECS_ASSERT(aEntity != nullentity);
+			BeginRecording();
+			ECS_ASSERT(Owns(aEntity) && "Placeholder was made by another buffer or before the last playback");
+			myCommands.push_back({ &ExecuteRemove<T>, nullptr, aEntity, nullptr });
+		}
+
+		void Destroy(Entity aEntity)
+		{
+			ECS_ASSERT(aEntity != nullentity);
+			BeginRecording();
+			ECS_ASSERT(Owns(aEntity) && "Placeholder was made by another buffer or before the last playback");
+			myCommands.push_back({ &ExecuteDestroy, nullptr, aEntity, nullptr });
+		}
+
+		// Applies every command in the order it was recorded. Commands on entities that have been destroyed in the
+		// meantime are skipped. Placeholders can be resolved until the next command is recorded.
+		void Playback(Registry& aRegistry)
+		{
+			for (Command& command : myCommands)
+			{
+				command.execute(*this, aRegistry, command);
+				if (command.release)
+					command.release(command.payload);
+			}
+
+			myCommands.clear();
+			ResetBlocks();
+			myPlayedBack = true;
+		}
+
+		// Maps a placeholder from the last playback to the entity that was created for it
+		Entity Resolve(Entity aEntity) const
+		{
+			if (!IsPlaceholder(aEntity))
+				return aEntity;
+
+			ECS_ASSERT(myPlayedBack && Owns(aEntity) && "Placeholder has not been played back by this buffer");
+			return Lookup(aEntity);
+		}
+
+		bool Empty() const
+		{
+			return myCommands.empty();
+		}
+
+		size_t Size() const
+		{
+			return myCommands.size();
+		}
+
+		// Drops every recorded command without applying it
+		void Clear()
+		{
+			for (Command& command : myCommands)
+			{
+				if (command.release)
+					command.release(command.payload);
+			}
+
+			myCommands.clear();
+			StartRecording();
+			myPlayedBack = false;
+			ResetBlocks();
+		}
+
+	private:
+		struct Command
+		{
+			void (*execute)(CommandBuffer&, Registry&, Command&);
+			void (*release)(void*);
+			Entity entity;
+			void* payload;
+		};
+
+		static constexpr size_t BlockSize = 16 * 1024;
+
+		// A placeholder's index is a chunk of detail::PlaceholderChunks and the position in it
+		static constexpr Entity ChunkBits = detail::PlaceholderChunks::ChunkBits;
+		static constexpr Entity ChunkMask = detail::PlaceholderChunks::ChunkSize - 1;
+
+		// Placeholders of the previous playback stay resolvable until something new is recorded
+		void BeginRecording()
+		{
+			if (myPlayedBack)
+			{
+				StartRecording();
+				myPlayedBack = false;
+			}
+		}
+
+		// Gives the chunks back, placeholders made so far stop being accepted
+		void StartRecording()
+		{
+			for (Entity chunk : myChunks)
+				detail::PlaceholderChunks::Release(chunk);
+			myChunks.clear();
+			myCreated.clear();
+			myRecording = detail::PlaceholderChunks::NextRecording();
+		}
+
+		// Position of a placeholder in myCreated, or myCreated.size() if this recording didn't make it
+		size_t Slot(Entity aPlaceholder) const
+		{
+			const Entity index = EntityTraits::Index(aPlaceholder);
+			const size_t slot = (size_t(detail::PlaceholderChunks::PositionIn(index >> ChunkBits, myRecording)) << ChunkBits) | (index & ChunkMask);
+			return (std::min)(slot, myCreated.size());
+		}
+
+		// Real entities, and placeholders this buffer handed out since it last started recording
+		bool Owns(Entity aEntity) const
+		{
+			return !IsPlaceholder(aEntity) || Slot(aEntity) < myCreated.size();
+		}
+
+		// Unknown placeholders come back as nullentity, which is never alive, so their commands are skipped
+		Entity Lookup(Entity aEntity) const
+		{
+			if (!IsPlaceholder(aEntity))
+				return aEntity;
+			const size_t slot = Slot(aEntity);
+			return slot < myCreated.size() ? myCreated[slot] : nullentity;
+		}
+
+		static void ExecuteCreate(CommandBuffer& aBuffer, Registry& aRegistry, Command& aCommand)
+		{
+			aBuffer.myCreated[aBuffer.Slot(aCommand.entity)] = aRegistry.Create();
+		}
+
+		template <typename T>
+		static void ExecuteEmplace(CommandBuffer& aBuffer, Registry& aRegistry, Command& aCommand)
+		{
+			const Entity entity = aBuffer.Lookup(aCommand.entity);
+			if (aRegistry.Alive(entity))
+				aRegistry.EmplaceOrReplace<T>(entity, std::move(*static_cast<T*>(aCommand.payload)));
+		}
+
+		template <typename T>
+		static void ExecuteRemove(CommandBuffer& aBuffer, Registry& aRegistry, Command& aCommand)
+		{
+			const Entity entity = aBuffer.Lookup(aCommand.entity);
+			if (aRegistry.Alive(entity) && aRegistry.Contains<T>(entity))
+				aRegistry.Remove<T>(entity);
+		}
+
+		static void ExecuteDestroy(CommandBuffer& aBuffer, Registry& aRegistry, Command& aCommand)
+		{
+			const Entity entity = aBuffer.Lookup(aCommand.entity);
+			if (aRegistry.Alive(entity))
+				aRegistry.Destroy(entity);
+		}
+
+		template <typename T>
+		static void Release(void* aPayload)
+		{
+			static_cast<T*>(aPayload)->~T();
+		}
+
+		// Payloads are bump allocated from blocks that are kept between playbacks
+		template <typename T>
+		T* Allocate()
+		{
+			static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned components can't be recorded");
+
+			const size_t size = (sizeof(T) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t) * sizeof(std::max_align_t);
+			if (size > BlockSize)
+			{
+				myLargeBlocks.emplace_back(new std::max_align_t[size / sizeof(std::max_align_t)]);
+				return reinterpret_cast<T*>(myLargeBlocks.back().get());
+			}
+
+			if (myBlock < myBlocks.size() && myOffset + size > BlockSize)
+			{
+				++myBlock;
+				myOffset = 0;
+			}
+			if (myBlock == myBlocks.size())
+				myBlocks.emplace_back(new std::max_align_t[BlockSize / sizeof(std::max_align_t)]);
+
+			T* result = reinterpret_cast<T*>(reinterpret_cast<std::byte*>(myBlocks[myBlock].get()) + myOffset);
+			myOffset += size;
+			return result;
+		}
+
+		void ResetBlocks()
+		{
+			myBlock = 0;
+			myOffset = 0;
+			myLargeBlocks.clear();
+		}
+
+		std::vector<Command> myCommands;
+		std::vector<Entity> myCreated;
+		std::vector<Entity> myChunks;
+		uint64_t myRecording;
+		bool myPlayedBack = false;
+
+		std::vector<std::unique_ptr<std::max_align_t[]>> myBlocks;
+		std::vector<std::unique_ptr<std::max_align_t[]>> myLargeBlocks;
+		size_t myBlock = 0;
+		size_t myOffset = 0;
+	};
+
+	// One command buffer per thread. A thread only takes the lock the first time it asks for its buffer,
+	// recording afterwards is lock free. Buffers are played back in the order their threads first asked for one.
+	class CommandBuffers
+	{
+	public:
+		CommandBuffers() : myId(NextId())
+		{}
+
+		CommandBuffer& Local()
+		{
+			// The set owns the buffers, the thread only remembers the last few it used. Entries are keyed on an id
+			// rather than the address, so a new set at the same address never finds stale buffers
+			thread_local std::array<CacheEntry, CacheSize> cache;
+			thread_local size_t next = 0;
+			for (CacheEntry& entry : cache)
+			{
+				if (entry.owner == myId)
+					return *entry.buffer;
+			}
+
+			CommandBuffer& buffer = Find(std::this_thread::get_id());
+			cache[next++ % CacheSize] = { myId, &buffer };
+			return buffer;
+		}
+
+		// Must not run while other threads are recording
+		void Playback(Registry& aRegistry)
+		{
+			for (auto& [thread, buffer] : myBuffers)
+				buffer->Playback(aRegistry);
+		}
+
+	private:
+		static constexpr size_t CacheSize = 4;
+
+		struct CacheEntry
+		{
+			size_t owner = SIZE_MAX;
+			CommandBuffer* buffer = nullptr;
+		};
+
+		static size_t NextId()
+		{
+			static std::atomic<size_t> id{ 0 };
+			return id++;
+		}
+
+		CommandBuffer& Find(std::thread::id aThread)
+		{
+			std::lock_guard<std::mutex> lock(myMutex);
+			for (auto& [thread, buffer] : myBuffers)
+			{
+				if (thread == aThread)
+					return *buffer;
+			}
+			myBuffers.emplace_back(aThread, new CommandBuffer());
+			return *myBuffers.back().second;
+		}
+
+		const size_t myId;
+		std::mutex myMutex;
+		std::vector<std::pair<std::thread::id, std::unique_ptr<CommandBuffer>>> myBuffers;
+	};
+}
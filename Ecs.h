@@ -1,20 +1,39 @@
 #pragma once
 #include "Assert.h"
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
 #include "Entity.h"
+#include "Signature.h"
 #include "Reference.h"
 #include "Heap.hpp"
 #include <tuple>
 #include "Exclude.h"
+#include "Get.h"
 #include "EntityIterator.h"
 #include "UpdateContext.h"
+#include "ThreadPool.h"
+#include "PagedVector.hpp"
+#include "SoAVector.hpp"
+#include "EmptyVector.hpp"
+#include "Span.hpp"
+#include "BinaryStream.hpp"
 #include <vector>
+#include <iterator>
+#include <memory_resource>
+#include <numeric>
+#include <type_traits>
+#include <utility>
 
 namespace ecs
 {
     template <typename...>
-    struct TList;
+    struct TList
+    {};
 
     class TypeID
     {
@@ -33,67 +52,667 @@ namespace ecs
         }
     };
 
+    // Specialize as std::true_type to keep T in fixed-size pages, so references to a component stay valid
+    // while the container grows. Removing a component still moves the last one into its place
+    template <typename T>
+    struct StableStorage : std::false_type
+    {};
+
+    template <auto... Members>
+    struct Fields
+    {
+        static constexpr size_t Count = sizeof...(Members);
+
+        template <typename T>
+        using Storage = mys::SoAVector<T, Members...>;
+    };
+
+    // Specialize as Fields<&T::x, &T::y, ...> (or use ECS_SOA_LAYOUT) to store each field of T in an array of its own.
+    // Such components are handed out through a proxy instead of T&, and containers and views expose per-field spans.
+    // Every field has to be listed, see mys::PartialSoA for leaving some out
+    template <typename T>
+    struct SoALayout : Fields<>
+    {};
+
+#define ECS_SOA_LAYOUT(Type, ...) template <> struct ecs::SoALayout<Type> : ecs::Fields<__VA_ARGS__> {}
+
+    // Empty components are tags. They only record membership, take no component storage and views hand out no element for them
+    template <typename T>
+    constexpr bool IsTag = std::is_empty_v<T>;
+
+    // How a component is written to snapshots. Trivially copyable components are copied bytewise, whole arrays at a
+    // time. Anything else has to specialize this with Bulk = false and
+    //     template <typename Writer> static void Save(Writer& aWriter, const T& aComponent);
+    //     template <typename Reader> static T Load(Reader& aReader);
+    template <typename T>
+    struct Serializer
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Specialize ecs::Serializer to snapshot components that aren't trivially copyable");
+        static constexpr bool Bulk = true;
+    };
+
+    namespace detail
+    {
+        // Snapshot writers take Write(const void*, size_t) and readers Read(void*, size_t), these move single values
+        template <typename Writer, typename T>
+        void WriteValue(Writer& aWriter, const T& aValue)
+        {
+            aWriter.Write(&aValue, sizeof(T));
+        }
+
+        template <typename T, typename Reader>
+        T ReadValue(Reader& aReader)
+        {
+            T value{};
+            aReader.Read(&value, sizeof(T));
+            return value;
+        }
+
+        template <typename Reader, typename = void>
+        struct CanFail : std::false_type
+        {};
+
+        template <typename Reader>
+        struct CanFail<Reader, std::void_t<decltype(std::declval<const Reader&>().Failed())>> : std::true_type
+        {};
+
+        // Readers that can run out, like mys::BinaryReader, tell through Failed. Others are trusted to hold the whole
+        // stream
+        template <typename Reader>
+        bool ReadFailed(const Reader& aReader)
+        {
+            if constexpr (CanFail<Reader>::value)
+                return aReader.Failed();
+            else
+                return false;
+        }
+
+        // Lists whose length isn't known up front are written in runs of at most RunLength entries, each preceded by
+        // its length and the last one empty, so neither writing nor reading them takes more than a fixed buffer
+        constexpr Entity RunLength = 256;
+
+        template <typename T, typename Func>
+        class RunWriter
+        {
+        public:
+            explicit RunWriter(Func aFlush) : myFlush(aFlush)
+            {}
+
+            void Push(const T& aValue)
+            {
+                myRun[myCount++] = aValue;
+                if (myCount == RunLength)
+                    Flush();
+            }
+
+            // Writes what is left and the empty run that ends the list
+            void Finish()
+            {
+                if (myCount)
+                    Flush();
+                Flush();
+            }
+
+        private:
+            void Flush()
+            {
+                myFlush(myRun.data(), myCount);
+                myCount = 0;
+            }
+
+            std::array<T, RunLength> myRun;
+            Entity myCount = 0;
+            Func myFlush;
+        };
+
+        // aFlush(const T* someValues, Entity aCount) writes a run, its length included
+        template <typename T, typename Func>
+        RunWriter<T, Func> MakeRunWriter(Func aFlush)
+        {
+            return RunWriter<T, Func>(aFlush);
+        }
+
+        // Length of the next run, 0 once the list has ended. Corrupt streams can hold anything, so lengths above
+        // RunLength have to be rejected before the run is read
+        template <typename Reader>
+        Entity ReadRunLength(Reader& aReader)
+        {
+            return ReadValue<Entity>(aReader);
+        }
+
+        // LEB128, seven bits per byte
+        template <typename Writer>
+        void WriteVarint(Writer& aWriter, uint64_t aValue)
+        {
+            uint8_t bytes[10];
+            size_t count = 0;
+            do
+            {
+                bytes[count] = static_cast<uint8_t>(aValue & 0x7f);
+                aValue >>= 7;
+                bytes[count++] |= aValue ? 0x80 : 0;
+            } while (aValue);
+            aWriter.Write(bytes, count);
+        }
+
+        template <typename Reader>
+        uint64_t ReadVarint(Reader& aReader)
+        {
+            uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                const uint8_t byte = ReadValue<uint8_t>(aReader);
+                value |= uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    break;
+            }
+            return value;
+        }
+
+        // Encodes aCurrent against aBaseline as alternating runs: the number of equal bytes to skip, then a number of
+        // bytes to XOR in. Stretches of equal bytes shorter than a few bytes stay inside the XOR run, where they cost
+        // less than starting a new one
+        template <typename Writer>
+        void WriteXorDelta(Writer& aWriter, const void* aBaseline, const void* aCurrent, size_t aSize)
+        {
+            constexpr size_t MinSkip = 4;
+            const uint8_t* baseline = static_cast<const uint8_t*>(aBaseline);
+            const uint8_t* current = static_cast<const uint8_t*>(aCurrent);
+
+            size_t position = 0;
+            while (position < aSize)
+            {
+                size_t start = position;
+                while (position + sizeof(uint64_t) <= aSize && std::memcmp(baseline + position, current + position, sizeof(uint64_t)) == 0)
+                    position += sizeof(uint64_t);
+                while (position < aSize && baseline[position] == current[position])
+                    ++position;
+                WriteVarint(aWriter, position - start);
+                if (position == aSize)
+                    break;
+
+                start = position;
+                size_t equal = 0;
+                while (position < aSize && equal < MinSkip)
+                {
+                    equal = (baseline[position] == current[position]) ? equal + 1 : 0;
+                    ++position;
+                }
+                position -= equal;
+                WriteVarint(aWriter, position - start);
+
+                uint8_t buffer[256];
+                for (size_t i = start; i < position; i += sizeof(buffer))
+                {
+                    const size_t count = (std::min)(sizeof(buffer), position - i);
+                    for (size_t j = 0; j < count; ++j)
+                        buffer[j] = baseline[i + j] ^ current[i + j];
+                    aWriter.Write(buffer, count);
+                }
+            }
+        }
+
+        // Turns the baseline in aData into the current bytes, only the XOR runs are touched. False for runs that reach
+        // past aSize or are empty, which no delta of the same data has
+        template <typename Reader>
+        bool ReadXorDelta(Reader& aReader, void* aData, size_t aSize)
+        {
+            uint8_t* data = static_cast<uint8_t*>(aData);
+
+            size_t position = 0;
+            while (position < aSize)
+            {
+                const uint64_t skip = ReadVarint(aReader);
+                if (skip > aSize - position)
+                    return false;
+                position += static_cast<size_t>(skip);
+                if (position == aSize)
+                    break;
+
+                const uint64_t length = ReadVarint(aReader);
+                if (length == 0 || length > aSize - position)
+                    return false;
+                const size_t end = position + length;
+
+                uint8_t buffer[256];
+                while (position < end)
+                {
+                    const size_t count = (std::min)(sizeof(buffer), end - position);
+                    aReader.Read(buffer, count);
+                    for (size_t j = 0; j < count; ++j)
+                        data[position + j] ^= buffer[j];
+                    position += count;
+                }
+            }
+            return true;
+        }
+
+        // The elements as one array, page by page
+        template <typename Writer, typename T>
+        void WritePaged(Writer& aWriter, const mys::PagedVector<T>& someElements)
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < someElements.size(); i += count)
+            {
+                const T* chunk = someElements.Chunk(i, count);
+                aWriter.Write(chunk, count * sizeof(T));
+            }
+        }
+
+        template <typename Reader, typename T>
+        void ReadPaged(Reader& aReader, mys::PagedVector<T>& someElements, size_t aCount)
+        {
+            someElements.resize(aCount);
+            size_t count = 0;
+            for (size_t i = 0; i < aCount; i += count)
+            {
+                T* chunk = someElements.Chunk(i, count);
+                aReader.Read(chunk, count * sizeof(T));
+            }
+        }
+
+        // For every page of the elements both vectors have, a byte telling whether it changed followed by its XOR
+        // runs if it did, then the elements aCurrent has past the end of aBaseline. Pages shared with a fork are
+        // known to be equal without comparing them
+        template <typename Writer, typename T>
+        void WritePagedDelta(Writer& aWriter, const mys::PagedVector<T>& aBaseline, const mys::PagedVector<T>& aCurrent)
+        {
+            const size_t common = (std::min)(aBaseline.size(), aCurrent.size());
+            size_t count = 0;
+            for (size_t i = 0; i < common; i += count)
+            {
+                count = (std::min)(mys::PagedVector<T>::PageSize, common - i);
+                size_t available = 0;
+                const T* baseline = aBaseline.Chunk(i, available);
+                const T* current = aCurrent.Chunk(i, available);
+                const bool changed = baseline != current && std::memcmp(baseline, current, count * sizeof(T)) != 0;
+                WriteValue(aWriter, static_cast<uint8_t>(changed));
+                if (changed)
+                    WriteXorDelta(aWriter, baseline, current, count * sizeof(T));
+            }
+            for (size_t i = common; i < aCurrent.size(); i += count)
+            {
+                const T* chunk = aCurrent.Chunk(i, count);
+                aWriter.Write(chunk, count * sizeof(T));
+            }
+        }
+
+        // someElements hold the baseline and have already been resized, only the pages that changed are written to
+        template <typename Reader, typename T>
+        bool ReadPagedDelta(Reader& aReader, mys::PagedVector<T>& someElements, size_t aBaselineCount)
+        {
+            const size_t common = (std::min)(aBaselineCount, someElements.size());
+            size_t count = 0;
+            for (size_t i = 0; i < common; i += count)
+            {
+                count = (std::min)(mys::PagedVector<T>::PageSize, common - i);
+                size_t available = 0;
+                if (ReadValue<uint8_t>(aReader) && !ReadXorDelta(aReader, someElements.Chunk(i, available), count * sizeof(T)))
+                    return false;
+            }
+            for (size_t i = common; i < someElements.size(); i += count)
+            {
+                T* chunk = someElements.Chunk(i, count);
+                aReader.Read(chunk, count * sizeof(T));
+            }
+            return !ReadFailed(aReader);
+        }
+
+        // Indices of the types a view hands out, which is every type but the tags
+        template <typename... Types>
+        struct PayloadIndices
+        {
+            static constexpr size_t Count = (size_t(!IsTag<Types>) + ... + 0);
+
+            static constexpr std::array<size_t, Count> Indices()
+            {
+                constexpr bool payload[] = { !IsTag<Types>..., false };
+                std::array<size_t, Count> indices{};
+                size_t count = 0;
+                for (size_t i = 0; i < sizeof...(Types); ++i)
+                {
+                    if (payload[i])
+                        indices[count++] = i;
+                }
+                return indices;
+            }
+
+            template <size_t... J>
+            static std::index_sequence<Indices()[J]...> Make(std::index_sequence<J...>);
+
+            using Sequence = decltype(Make(std::make_index_sequence<Count>{}));
+        };
+
+        // Position of T in Types, or sizeof...(Types) if it isn't there
+        template <typename T, typename... Types>
+        constexpr size_t IndexOf()
+        {
+            size_t index = 0;
+            ((std::is_same_v<T, Types> ? false : (++index, true)) && ...);
+            return index;
+        }
+
+        // A T that forked registries share until one of them writes to it, the writer gets a copy of its own first.
+        // T is copy constructed for that and has to allocate the copy from the same resource as the original
+        template <typename T>
+        class CopyOnWrite
+        {
+        public:
+            template <typename... Args>
+            explicit CopyOnWrite(std::pmr::memory_resource* aResource, Args&&... args) :
+                myBlock(New(aResource, std::forward<Args>(args)...)), myResource(aResource)
+            {}
+
+            CopyOnWrite(const CopyOnWrite& anOther) : myBlock(anOther.myBlock), myResource(anOther.myResource)
+            {
+                myBlock->references.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            CopyOnWrite& operator=(const CopyOnWrite& anOther)
+            {
+                anOther.myBlock->references.fetch_add(1, std::memory_order_relaxed);
+                Release();
+                myBlock = anOther.myBlock;
+                myResource = anOther.myResource;
+                return *this;
+            }
+
+            ~CopyOnWrite()
+            {
+                Release();
+            }
+
+            const T& Read() const
+            {
+                return myBlock->value;
+            }
+
+            T& Write()
+            {
+                if (Shared())
+                    Unshare();
+                return myBlock->value;
+            }
+
+            bool Shared() const
+            {
+                return myBlock->references.load(std::memory_order_acquire) != 1;
+            }
+
+        private:
+            struct Block
+            {
+                template <typename... Args>
+                explicit Block(Args&&... args) : value(std::forward<Args>(args)...)
+                {}
+
+                T value;
+                std::atomic<size_t> references = 1;
+            };
+
+            template <typename... Args>
+            static Block* New(std::pmr::memory_resource* aResource, Args&&... args)
+            {
+                return new (aResource->allocate(sizeof(Block), alignof(Block))) Block(std::forward<Args>(args)...);
+            }
+
+            void Unshare()
+            {
+                Block* copy = New(myResource, static_cast<const T&>(myBlock->value));
+                Release();
+                myBlock = copy;
+            }
+
+            void Release()
+            {
+                if (myBlock->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    myBlock->~Block();
+                    myResource->deallocate(myBlock, sizeof(Block), alignof(Block));
+                }
+            }
+
+            Block* myBlock;
+            std::pmr::memory_resource* myResource;
+        };
+
+        inline std::atomic<uint32_t> changeVersion = 1;
+    }
+
+    // Components handed out for writing stamp their chunk in the set with the current version, one process wide counter
+    // shared by every registry. A system that wants what changed between its runs keeps the version it last ran at:
+    //
+    //     registry.View<Transform>().ChangedSince(myLastRun).Each(...);
+    //     myLastRun = ecs::AdvanceVersion();
+    using Version = uint32_t;
+
+    inline Version CurrentVersion()
+    {
+        return detail::changeVersion.load(std::memory_order_relaxed);
+    }
+
+    // Closes the current version and returns it, everything written from here on is stamped with a newer one
+    inline Version AdvanceVersion()
+    {
+        return detail::changeVersion.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    namespace detail
+    {
+        // Version stamp of one chunk. Workers of a parallel loop stamp the chunks at the edges of their ranges, and
+        // the components they look up by entity, at the same time. Copyable so the stamps can live in a vector
+        class ChunkStamp
+        {
+        public:
+            ChunkStamp(Version aVersion = 0) : myVersion(aVersion)
+            {}
+
+            ChunkStamp(const ChunkStamp& anOther) : myVersion(anOther.Load())
+            {}
+
+            ChunkStamp& operator=(const ChunkStamp& anOther)
+            {
+                myVersion.store(anOther.Load(), std::memory_order_relaxed);
+                return *this;
+            }
+
+            Version Load() const
+            {
+                return myVersion.load(std::memory_order_relaxed);
+            }
+
+            // Only writes if the version is new, so stamping a chunk over and over doesn't keep its line bouncing
+            void Stamp(Version aVersion)
+            {
+                if (Load() != aVersion)
+                    myVersion.store(aVersion, std::memory_order_relaxed);
+            }
+
+        private:
+            std::atomic<Version> myVersion;
+        };
+    }
+
     template <typename T>
     class SparseSet
     {
     public:
         using IdType = Entity;
 
-        SparseSet() : dense(nullptr), sparse(nullptr), size(0), capacity(0), sparse_capacity(0)
+        static constexpr bool IsSoA = SoALayout<T>::Count > 0;
+        using Storage = std::conditional_t<IsSoA, typename SoALayout<T>::template Storage<T>,
+            std::conditional_t<IsTag<T>, mys::EmptyVector<T>,
+            std::conditional_t<StableStorage<T>::value, mys::PagedVector<T>, std::pmr::vector<T>>>>;
+        using Reference = decltype(std::declval<Storage&>()[0]);
+        using ConstReference = decltype(std::declval<const Storage&>()[0]);
+
+        // The sparse index is split into pages that are only allocated once an id inside them is added and freed once
+        // the last one is removed, so memory follows the ids actually in the set rather than the largest one
+        static constexpr IdType PageSize = 4096;
+        static_assert((PageSize & (PageSize - 1)) == 0, "Page size has to be a power of two");
+
+        // Number of packed components that share a change version. Get, Emplace, Front and everything that moves
+        // components stamp their chunk, operator[] and Chunk leave it to the caller through Touch
+        static constexpr IdType VersionChunk = 64;
+
+        // Every array of the set, components included, is allocated from aResource
+        explicit SparseSet(std::pmr::memory_resource* aResource = std::pmr::get_default_resource()) :
+            mirror(aResource), versions(aResource), scratch(aResource), dense(nullptr), sparse(nullptr), live(nullptr), size(0), capacity(0), page_count(0), resource(aResource)
         {}
 
+        // Copies the dense array, the sparse pages and the versions whole into memory from the same resource, used when
+        // forked registries stop sharing a set. Components in vector or SoA storage are copied whole as well, only
+        // paged components keep sharing their pages so that just the pages written to afterwards are copied
+        SparseSet(const SparseSet& anOther) : SparseSet(anOther.resource)
+        {
+            if constexpr (std::is_copy_constructible_v<T>)
+            {
+                if constexpr (std::is_same_v<Storage, mys::PagedVector<T>>)
+                    mirror = anOther.mirror;
+                Reserve(anOther.size);
+                std::copy(anOther.dense, anOther.dense + anOther.size, dense);
+                for (IdType i = 0; i < anOther.page_count; ++i)
+                {
+                    if (anOther.sparse[i])
+                    {
+                        std::copy(anOther.sparse[i], anOther.sparse[i] + PageSize, Page(i));
+                        live[i] = anOther.live[i];
+                    }
+                }
+                if constexpr (std::is_same_v<Storage, std::pmr::vector<T>>)
+                    mirror.assign(anOther.mirror.begin(), anOther.mirror.end());
+                else if constexpr (!std::is_same_v<Storage, mys::PagedVector<T>>)
+                {
+                    for (IdType i = 0; i < anOther.size; ++i)
+                        mirror.push_back(anOther.mirror[i]);
+                }
+                versions.assign(anOther.versions.begin(), anOther.versions.end());
+                size = anOther.size;
+            }
+            else
+            {
+                // Registry::Fork refuses registries holding such components, so getting here means the set was copied
+                // some other way and there is no state left to continue from
+                ECS_ASSERT(false && "Components that can't be copied can't be forked");
+                std::terminate();
+            }
+        }
+
+        SparseSet& operator=(const SparseSet&) = delete;
+
+        // Copies the component pages still shared with a fork, so the components can be written to from several
+        // threads. Everything else of the set is copied as a whole when it stops being shared
+        void Unshare()
+        {
+            if constexpr (std::is_same_v<Storage, mys::PagedVector<T>>)
+                mirror.Unshare();
+        }
+
         ~SparseSet()
         {
             //delete[] mirror;
-            delete[] dense;
-            delete[] sparse;
+            Deallocate(dense, capacity);
+            ReleasePages();
+        }
+
+        Reference operator[](IdType index)
+        {
+            return mirror[index];
         }
 
-        T& operator[](IdType index)
+        ConstReference operator[](IdType index) const
         {
             return mirror[index];
         }
         
         void Clear()
         {
-            delete[] dense;
-            delete[] sparse;
+            Deallocate(dense, capacity);
+            ReleasePages();
+            mirror.clear();
+            mirror.shrink_to_fit();
+            versions.clear();
+            versions.shrink_to_fit();
             dense = nullptr;
-            sparse = nullptr;
             size = 0;
             capacity = 0;
-            sparse_capacity = 0;
         }
 
         template <typename... Args>
-        T& Emplace(IdType id, Args&&... args)
+        Reference Emplace(IdType id, Args&&... args)
         {
             ECS_ASSERT(!Contains(id));
-            Grow(id);
+            const IdType index = EntityTraits::Index(id);
+            Grow(index);
+            if (size / VersionChunk == versions.size())
+                versions.push_back(0);
+            Stamp(size);
             dense[size] = id;
-            sparse[id] = size++;
-            mirror.emplace_back(std::forward<Args>(args)...);
+            Sparse(index) = size++;
+            ++live[index / PageSize];
+            if constexpr (std::is_aggregate_v<T>)
+                mirror.push_back(T{ std::forward<Args>(args)... });
+            else
+                mirror.emplace_back(std::forward<Args>(args)...);
             
             return mirror[size-1];
         }
 
+        void Reserve(size_t aCapacity)
+        {
+            mirror.reserve(aCapacity);
+            versions.reserve((aCapacity + VersionChunk - 1) / VersionChunk);
+            if (aCapacity <= capacity)
+                return;
+
+            IdType* tmp = Allocate<IdType>(aCapacity);
+            std::copy(dense, dense + size, tmp);
+            Deallocate(dense, capacity);
+            dense = tmp;
+            capacity = static_cast<IdType>(aCapacity);
+        }
+
         void Remove(IdType id)
         {
             ECS_ASSERT(Contains(id) && "Removing nonexisting element");
-            IdType denseIndex = sparse[id];
+            IdType denseIndex = Sparse(EntityTraits::Index(id));
 
             --size;
-            std::swap(mirror.back(), mirror[denseIndex]);
+            if (denseIndex != size)
+                Stamp(denseIndex);
+            SwapComponents(size, denseIndex);
             std::swap(dense[size], dense[denseIndex]);
-            sparse[dense[denseIndex]] = denseIndex;
+            Sparse(EntityTraits::Index(dense[denseIndex])) = denseIndex;
 
             auto tmp = std::move(mirror.back()); // Have to do this since it seems back is changed after destructor is called on object
             mirror.pop_back();
+
+            const IdType page = EntityTraits::Index(id) / PageSize;
+            if (--live[page] == 0)
+                FreePage(page);
         }
 
         inline bool Contains(IdType id) const
         {
-            return id < sparse_capacity && sparse[id] < size && dense[sparse[id]] == id;
+            const IdType index = EntityTraits::Index(id);
+            const IdType page = index / PageSize;
+            if (page >= page_count || !sparse[page])
+                return false;
+
+            const IdType denseIndex = sparse[page][index & (PageSize - 1)];
+            return denseIndex < size && dense[denseIndex] == id;
+        }
+
+        // The id in the set with the same index as id, whatever its version, or nullentity
+        IdType Occupant(IdType id) const
+        {
+            const IdType index = EntityTraits::Index(id);
+            const IdType page = index / PageSize;
+            if (page >= page_count || !sparse[page])
+                return nullentity;
+
+            const IdType denseIndex = sparse[page][index & (PageSize - 1)];
+            return denseIndex < size && EntityTraits::Index(dense[denseIndex]) == index ? dense[denseIndex] : nullentity;
         }
 
         IdType& DenseFront()
@@ -101,70 +720,655 @@ namespace ecs
             return *dense;
         }
 
-        T& Front()
+        IdType* DenseData()
         {
-            ECS_ASSERT(size && "Set is empty");
-            return mirror.front();
+            return dense;
         }
 
-        T& Get(IdType id)
+        const IdType* DenseData() const
         {
-            return mirror[sparse[id]];
+            return dense;
         }
 
-        const T& Get(IdType id) const
+        // Pointer to the component at pos and how many components follow it contiguously
+        T* Chunk(IdType pos, size_t& count)
         {
-            return mirror[sparse[id]];
+            static_assert(!IsSoA && !IsTag<T>, "SoA components and tags have no contiguous T to point at");
+            if constexpr (StableStorage<T>::value)
+                return mirror.Chunk(pos, count);
+            else
+            {
+                count = size - pos;
+                return mirror.data() + pos;
+            }
         }
 
-        size_t Size() const
+        const T* Chunk(IdType pos, size_t& count) const
         {
-            return size;
+            static_assert(!IsSoA && !IsTag<T>, "SoA components and tags have no contiguous T to point at");
+            if constexpr (StableStorage<T>::value)
+                return mirror.Chunk(pos, count);
+            else
+            {
+                count = size - pos;
+                return mirror.data() + pos;
+            }
         }
 
-    private:
-        inline void Grow(IdType id)
+        // Version of the last write to the chunk holding the component at position
+        Version ChunkVersion(IdType position) const
         {
-            if (size >= capacity)
+            return versions[position / VersionChunk].Load();
+        }
+
+        // Whether any chunk was stamped after aVersion
+        bool WrittenSince(Version aVersion) const
+        {
+            for (const detail::ChunkStamp& stamp : versions)
             {
-                capacity = capacity * 2 + 1;
-                IdType* tmp = new IdType[capacity];
-                memcpy(tmp, dense, size * sizeof(IdType));
-                delete[] dense;
-                dense = tmp;
+                if (stamp.Load() > aVersion)
+                    return true;
             }
-            if (id >= sparse_capacity)
+            return false;
+        }
+
+        // Stamps the chunks of the components in [first, last) with the current version
+        void Touch(IdType first, IdType last)
+        {
+            if (first >= last)
+                return;
+            const Version version = CurrentVersion();
+            for (IdType chunk = first / VersionChunk; chunk <= (last - 1) / VersionChunk; ++chunk)
+                versions[chunk].Stamp(version);
+        }
+
+        // Dense position of a component stored in this set, or Size() if it isn't
+        IdType PositionOf(const T& component) const
+        {
+            static_assert(!IsSoA && !IsTag<T>, "SoA components and tags have no address to look up");
+            if constexpr (StableStorage<T>::value)
+                return static_cast<IdType>(mirror.IndexOf(&component));
+            else
             {
-                IdType tmpcap = sparse_capacity;
-                sparse_capacity = id * 2 + 1;
-                IdType* tmp = new IdType[sparse_capacity];
-                memcpy(tmp, sparse, tmpcap * sizeof(IdType));
-                delete[] sparse;
-                sparse = tmp;
+                const T* data = mirror.data();
+                return (&component >= data && &component < data + size) ? static_cast<IdType>(&component - data) : size;
             }
         }
 
-        IdType size;
-        IdType capacity;
+        // The array holding one field of every component, in dense order
+        template <auto Member>
+        auto* Field()
+        {
+            static_assert(IsSoA, "Only components with an SoA layout store their fields apart");
+            return mirror.template Data<Member>();
+        }
 
-        IdType sparse_capacity;
+        template <auto Member>
+        const auto* Field() const
+        {
+            static_assert(IsSoA, "Only components with an SoA layout store their fields apart");
+            return mirror.template Data<Member>();
+        }
 
-        std::vector<T> mirror;
-        IdType* dense;
-        IdType* sparse;
-    };
+        IdType DenseIndex(IdType id) const
+        {
+            ECS_ASSERT(Contains(id));
+            return Sparse(EntityTraits::Index(id));
+        }
 
-    class IContainer
-    {
-    public:
-        virtual ~IContainer() = default;
-        virtual bool Contains(Entity aEntity) const = 0;
-        virtual size_t Size() const = 0;
-        virtual Entity& DenseFront() = 0;
-        virtual Entity& DenseBack() = 0;
-        virtual void Destroy(Entity aEntity) = 0;
+        // Writes the dense ids and every allocated sparse page as one block each. Components follow as one block
+        // per array, page or field, unless their Serializer writes them one by one
+        template <typename Writer>
+        void Save(Writer& aWriter) const
+        {
+            detail::WriteValue(aWriter, size);
+            aWriter.Write(dense, size * sizeof(IdType));
+
+            IdType pages = 0;
+            for (IdType i = 0; i < page_count; ++i)
+                pages += sparse[i] != nullptr;
+            detail::WriteValue(aWriter, pages);
+            for (IdType i = 0; i < page_count; ++i)
+            {
+                if (!sparse[i])
+                    continue;
+                detail::WriteValue(aWriter, i);
+                aWriter.Write(sparse[i], PageSize * sizeof(IdType));
+            }
+
+            if constexpr (!Serializer<T>::Bulk)
+            {
+                for (IdType i = 0; i < size; ++i)
+                    Serializer<T>::Save(aWriter, mirror[i]);
+            }
+            else if constexpr (IsSoA)
+                mirror.EachField([this, &aWriter](const auto* aField) { aWriter.Write(aField, size * sizeof(*aField)); });
+            else if constexpr (StableStorage<T>::value && !IsTag<T>)
+            {
+                size_t count = 0;
+                for (size_t i = 0; i < size; i += count)
+                {
+                    const T* chunk = mirror.Chunk(i, count);
+                    aWriter.Write(chunk, count * sizeof(T));
+                }
+            }
+            else if constexpr (!IsTag<T>)
+                aWriter.Write(mirror.data(), size * sizeof(T));
+        }
+
+        // Sum of a hash per id and its component, which doesn't depend on the order of the packed arrays
+        uint64_t Hash() const
+        {
+            uint64_t sum = 0;
+            for (IdType i = 0; i < size; ++i)
+            {
+                mys::HashWriter element;
+                element.Write(&dense[i], sizeof(IdType));
+                if constexpr (!Serializer<T>::Bulk)
+                    Serializer<T>::Save(element, mirror[i]);
+                else if constexpr (IsSoA)
+                    mirror.EachField([&element, i](const auto* aField) { element.Write(aField + i, sizeof(*aField)); });
+                else if constexpr (!IsTag<T>)
+                    element.Write(&mirror[i], sizeof(T));
+                sum += element.Hash();
+            }
+            return sum;
+        }
+
+        // Writes what changed from aBaseline to this set, keyed by entity: the removed ids, the added components and the
+        // changed ones as XOR runs against the baseline. Where both sets are in the same order, unchanged stretches
+        // are skipped a block at a time. Read back by Container::ApplyDelta
+        template <typename Writer>
+        void SaveDelta(const SparseSet& aBaseline, Writer& aWriter) const
+        {
+            auto removed = detail::MakeRunWriter<IdType>([&aWriter](const IdType* someIds, IdType aCount)
+            {
+                detail::WriteValue(aWriter, aCount);
+                aWriter.Write(someIds, aCount * sizeof(IdType));
+            });
+            for (IdType i = 0; i < aBaseline.size; ++i)
+            {
+                if (!Contains(aBaseline.dense[i]))
+                    removed.Push(aBaseline.dense[i]);
+            }
+            removed.Finish();
+
+            // Added and changed components are found in the same pass, the added ones go out first
+            auto added = detail::MakeRunWriter<IdType>([this, &aWriter](const IdType* somePositions, IdType aCount)
+            {
+                detail::WriteValue(aWriter, aCount);
+                for (IdType i = 0; i < aCount; ++i)
+                    detail::WriteValue(aWriter, dense[somePositions[i]]);
+                for (IdType i = 0; i < aCount; ++i)
+                {
+                    if constexpr (!Serializer<T>::Bulk)
+                        Serializer<T>::Save(aWriter, mirror[somePositions[i]]);
+                    else if constexpr (!IsTag<T>)
+                    {
+                        const T component = mirror[somePositions[i]];
+                        detail::WriteValue(aWriter, component);
+                    }
+                }
+            });
+            for (IdType i = 0; i < size; ++i)
+            {
+                if (!aBaseline.Contains(dense[i]))
+                    added.Push(i);
+            }
+            added.Finish();
+
+            auto changed = detail::MakeRunWriter<std::pair<IdType, IdType>>([this, &aBaseline, &aWriter](const std::pair<IdType, IdType>* somePositions, IdType aCount)
+            {
+                detail::WriteValue(aWriter, aCount);
+                for (IdType i = 0; i < aCount; ++i)
+                {
+                    const auto [position, baselinePosition] = somePositions[i];
+                    detail::WriteValue(aWriter, dense[position]);
+                    if constexpr (!Serializer<T>::Bulk)
+                        Serializer<T>::Save(aWriter, mirror[position]);
+                    else
+                    {
+                        const T baseline = aBaseline.mirror[baselinePosition];
+                        const T component = mirror[position];
+                        detail::WriteXorDelta(aWriter, &baseline, &component, sizeof(T));
+                    }
+                }
+            });
+            constexpr IdType Block = 64;
+            for (IdType i = 0; i < size;)
+            {
+                if (i + Block <= (std::min)(size, aBaseline.size) && std::equal(dense + i, dense + i + Block, aBaseline.dense + i) &&
+                    SameComponents(aBaseline, i, i, Block))
+                {
+                    i += Block;
+                    continue;
+                }
+
+                const IdType id = dense[i];
+                if (i < aBaseline.size && aBaseline.dense[i] == id)
+                {
+                    if (!SameComponents(aBaseline, i, i, 1))
+                        changed.Push({ i, i });
+                }
+                else if (aBaseline.Contains(id))
+                {
+                    const IdType position = aBaseline.Sparse(EntityTraits::Index(id));
+                    if (!SameComponents(aBaseline, i, position, 1))
+                        changed.Push({ i, position });
+                }
+                ++i;
+            }
+            changed.Finish();
+        }
+
+        // Reads what Save wrote into this set, which has to be empty. False if the reader ran out or the ids don't
+        // match someEntities, the entity table loaded alongside, in which case the set has to be cleared
+        template <typename Reader>
+        bool Load(Reader& aReader, const mys::PagedVector<IdType>& someEntities)
+        {
+            ECS_ASSERT(size == 0 && "Only empty sets can be loaded");
+
+            const IdType count = detail::ReadValue<IdType>(aReader);
+            if (count > someEntities.size())
+                return false;
+            Reserve(count);
+            aReader.Read(dense, count * sizeof(IdType));
+
+            const IdType pageLimit = static_cast<IdType>((someEntities.size() + PageSize - 1) / PageSize);
+            const IdType pages = detail::ReadValue<IdType>(aReader);
+            if (pages > pageLimit)
+                return false;
+            for (IdType i = 0; i < pages; ++i)
+            {
+                const IdType page = detail::ReadValue<IdType>(aReader);
+                if (page >= pageLimit)
+                    return false;
+                aReader.Read(Page(page), PageSize * sizeof(IdType));
+            }
+
+            if constexpr (!Serializer<T>::Bulk)
+            {
+                for (IdType i = 0; i < count; ++i)
+                    mirror.push_back(Serializer<T>::Load(aReader));
+            }
+            else
+            {
+                mirror.resize(count);
+                if constexpr (IsSoA)
+                    mirror.EachField([&aReader, count](auto* aField) { aReader.Read(aField, count * sizeof(*aField)); });
+                else if constexpr (StableStorage<T>::value && !IsTag<T>)
+                {
+                    size_t chunkCount = 0;
+                    for (size_t i = 0; i < count; i += chunkCount)
+                    {
+                        T* chunk = mirror.Chunk(i, chunkCount);
+                        aReader.Read(chunk, chunkCount * sizeof(T));
+                    }
+                }
+                else if constexpr (!IsTag<T>)
+                    aReader.Read(mirror.data(), count * sizeof(T));
+            }
+            versions.assign((count + VersionChunk - 1) / VersionChunk, CurrentVersion());
+            size = count;
+
+            // Every id has to be alive in the table and found through the sparse pages at its own position
+            for (IdType i = 0; i < count; ++i)
+            {
+                const IdType index = EntityTraits::Index(dense[i]);
+                if (index >= someEntities.size() || someEntities[index] != dense[i] || !Contains(dense[i]) || Sparse(index) != i)
+                    return false;
+                ++live[index / PageSize];
+            }
+            for (IdType i = 0; i < page_count; ++i)
+            {
+                if (sparse[i] && live[i] == 0)
+                    FreePage(i);
+            }
+            return !detail::ReadFailed(aReader);
+        }
+
+        // Sorts the packed arrays in place, the comparator takes either two components or two entities
+        template <typename Func>
+        void Sort(Func&& aComparator)
+        {
+            std::pmr::vector<IdType>& order = scratch;
+            order.resize(size);
+            std::iota(order.begin(), order.end(), IdType(0));
+
+            if constexpr (std::is_invocable_v<Func, const T&, const T&>)
+                std::sort(order.begin(), order.end(), [this, &aComparator](IdType lhs, IdType rhs)
+                {
+                    // SoA components are gathered into temporaries here
+                    const T& left = mirror[lhs];
+                    const T& right = mirror[rhs];
+                    return aComparator(left, right);
+                });
+            else
+                std::sort(order.begin(), order.end(), [this, &aComparator](IdType lhs, IdType rhs) { return aComparator(dense[lhs], dense[rhs]); });
+
+            // Walks each cycle of the permutation once, so every component is moved exactly one time
+            for (IdType i = 0; i < size; ++i)
+            {
+                if (order[i] == i)
+                    continue;
+
+                T tmp = std::move(mirror[i]);
+                const IdType tmpId = dense[i];
+
+                IdType current = i;
+                while (order[current] != i)
+                {
+                    const IdType next = order[current];
+                    mirror[current] = std::move(mirror[next]);
+                    dense[current] = dense[next];
+                    Sparse(EntityTraits::Index(dense[current])) = current;
+                    order[current] = current;
+                    current = next;
+                }
+
+                mirror[current] = std::move(tmp);
+                dense[current] = tmpId;
+                Sparse(EntityTraits::Index(tmpId)) = current;
+                order[current] = current;
+            }
+            order.clear();
+            Touch(0, size);
+        }
+
+        // Moves the entities shared with the given range to the front, in the same order as the range.
+        // Entities that are not in the range end up after them in no particular order
+        void SortAs(const IdType* someEntities, size_t aCount)
+        {
+            IdType position = 0;
+            for (size_t i = 0; i < aCount && position < size; ++i)
+            {
+                if (Contains(someEntities[i]))
+                    SwapDense(DenseIndex(someEntities[i]), position++);
+            }
+        }
+
+        // Swaps two elements in the packed arrays and keeps the sparse index pointing at them
+        void SwapDense(IdType lhs, IdType rhs)
+        {
+            if (lhs == rhs)
+                return;
+
+            SwapComponents(lhs, rhs);
+            std::swap(dense[lhs], dense[rhs]);
+            Sparse(EntityTraits::Index(dense[lhs])) = lhs;
+            Sparse(EntityTraits::Index(dense[rhs])) = rhs;
+            Stamp(lhs);
+            Stamp(rhs);
+        }
+
+        Reference Front()
+        {
+            ECS_ASSERT(size && "Set is empty");
+            Stamp(0);
+            return mirror.front();
+        }
+
+        Reference Get(IdType id)
+        {
+            const IdType position = Sparse(EntityTraits::Index(id));
+            Stamp(position);
+            return mirror[position];
+        }
+
+        ConstReference Get(IdType id) const
+        {
+            return mirror[Sparse(EntityTraits::Index(id))];
+        }
+
+        size_t Size() const
+        {
+            return size;
+        }
+
+    private:
+        // Compares aCount components from position with the ones of anOther from otherPosition, bytewise or as their
+        // Serializer writes them
+        bool SameComponents(const SparseSet& anOther, IdType position, IdType otherPosition, IdType aCount) const
+        {
+            if constexpr (!Serializer<T>::Bulk)
+            {
+                for (IdType i = 0; i < aCount; ++i)
+                {
+                    mys::BinaryWriter lhs;
+                    mys::BinaryWriter rhs;
+                    Serializer<T>::Save(lhs, mirror[position + i]);
+                    Serializer<T>::Save(rhs, anOther.mirror[otherPosition + i]);
+                    if (lhs.Buffer() != rhs.Buffer())
+                        return false;
+                }
+                return true;
+            }
+            else if constexpr (IsTag<T>)
+                return true;
+            else if constexpr (IsSoA)
+                return mirror.Equal(anOther.mirror, position, otherPosition, aCount);
+            else if constexpr (StableStorage<T>::value)
+            {
+                for (IdType i = 0; i < aCount; ++i)
+                {
+                    if (std::memcmp(&mirror[position + i], &anOther.mirror[otherPosition + i], sizeof(T)) != 0)
+                        return false;
+                }
+                return true;
+            }
+            else
+                return std::memcmp(mirror.data() + position, anOther.mirror.data() + otherPosition, aCount * sizeof(T)) == 0;
+        }
+
+        void Stamp(IdType position)
+        {
+            versions[position / VersionChunk].Stamp(CurrentVersion());
+        }
+
+        void SwapComponents(IdType lhs, IdType rhs)
+        {
+            if constexpr (IsSoA)
+                mirror.Swap(lhs, rhs);
+            else if constexpr (IsTag<T>)
+                return;
+            else
+                std::swap(mirror[lhs], mirror[rhs]);
+        }
+
+        inline IdType& Sparse(IdType index)
+        {
+            return sparse[index / PageSize][index & (PageSize - 1)];
+        }
+
+        inline const IdType& Sparse(IdType index) const
+        {
+            return sparse[index / PageSize][index & (PageSize - 1)];
+        }
+
+        inline void Grow(IdType index)
+        {
+            if (size >= capacity)
+            {
+                const IdType newCapacity = capacity * 2 + 1;
+                IdType* tmp = Allocate<IdType>(newCapacity);
+                std::copy(dense, dense + size, tmp);
+                Deallocate(dense, capacity);
+                dense = tmp;
+                capacity = newCapacity;
+            }
+
+            Page(index / PageSize);
+        }
+
+        // The sparse page, allocated if it wasn't already
+        IdType* Page(IdType page)
+        {
+            if (page >= page_count)
+            {
+                // Only the page table is copied on growth, the pages themselves never move
+                IdType newCount = (std::max)(page + 1, page_count * 2);
+                IdType** tmp = Allocate<IdType*>(newCount);
+                std::copy(sparse, sparse + page_count, tmp);
+                std::fill(tmp + page_count, tmp + newCount, nullptr);
+                Deallocate(sparse, page_count);
+                sparse = tmp;
+
+                IdType* counts = Allocate<IdType>(newCount);
+                std::copy(live, live + page_count, counts);
+                std::fill(counts + page_count, counts + newCount, IdType(0));
+                Deallocate(live, page_count);
+                live = counts;
+                page_count = newCount;
+            }
+            if (!sparse[page])
+            {
+                sparse[page] = Allocate<IdType>(PageSize);
+                std::fill(sparse[page], sparse[page] + PageSize, nullentity);
+            }
+            return sparse[page];
+        }
+
+        // The page table itself stays, it is a pointer and a count per page
+        void FreePage(IdType page)
+        {
+            Deallocate(sparse[page], PageSize);
+            sparse[page] = nullptr;
+            live[page] = 0;
+        }
+
+        void ReleasePages()
+        {
+            for (IdType i = 0; i < page_count; ++i)
+                Deallocate(sparse[i], PageSize);
+            Deallocate(sparse, page_count);
+            Deallocate(live, page_count);
+            sparse = nullptr;
+            live = nullptr;
+            page_count = 0;
+        }
+
+        template <typename U>
+        U* Allocate(size_t count)
+        {
+            return static_cast<U*>(resource->allocate(count * sizeof(U), alignof(U)));
+        }
+
+        template <typename U>
+        void Deallocate(U* data, size_t count)
+        {
+            if (data)
+                resource->deallocate(data, count * sizeof(U), alignof(U));
+        }
+
+        IdType size;
+        IdType capacity;
+
+        IdType page_count;
+
+        Storage mirror;
+        std::pmr::vector<detail::ChunkStamp> versions;
+        // Reused by Sort, so sorting every frame doesn't take new memory from an arena that never frees
+        std::pmr::vector<IdType> scratch;
+        IdType* dense;
+        IdType** sparse;
+        // Ids in each sparse page
+        IdType* live;
+        std::pmr::memory_resource* resource;
+    };
+
+    // What Get, Emplace and views hand out for a T, a plain reference unless T has an SoA layout
+    template <typename T>
+    using ComponentRef = typename SparseSet<T>::Reference;
+
+    template <typename T>
+    using ConstComponentRef = typename SparseSet<T>::ConstReference;
+
+    // Callback for a single entity, used to keep groups in sync with their containers and for the registry's signals.
+    // A plain function pointer with its instance, so connecting one never allocates:
+    //
+    //     registry.OnConstruct<Collider>(ecs::Listener::Bind<&SpatialIndex::Insert>(index));
+    struct Listener
+    {
+        // Calls (anInstance.*Method)(entity)
+        template <auto Method, typename C>
+        static Listener Bind(C& anInstance)
+        {
+            return { &anInstance, [](void* anInstance, Entity aEntity) { (static_cast<C*>(anInstance)->*Method)(aEntity); } };
+        }
+
+        // Calls Function(entity)
+        template <auto Function>
+        static Listener Bind()
+        {
+            return { nullptr, [](void*, Entity aEntity) { Function(aEntity); } };
+        }
+
+        bool operator==(const Listener& aRhs) const
+        {
+            return instance == aRhs.instance && function == aRhs.function;
+        }
+
+        void* instance;
+        void (*function)(void*, Entity);
+    };
+
+    namespace detail
+    {
+        // Signals of one component type. The registry owns them per type id, so they outlive containers that Clear and
+        // Restore recreate
+        struct Signals
+        {
+            explicit Signals(std::pmr::memory_resource* aResource) : construct(aResource), destroy(aResource), update(aResource)
+            {}
+
+            std::pmr::vector<Listener> construct;
+            std::pmr::vector<Listener> destroy;
+            std::pmr::vector<Listener> update;
+        };
+    }
+
+    class IGroup
+    {
+    public:
+        virtual ~IGroup() = default;
+
+        // Destroys the group and hands its memory back to the resource it was allocated from
+        virtual void Delete(std::pmr::memory_resource* aResource) = 0;
+    };
+
+    enum class ContactKind : uint8_t
+    {
+        CollisionEnter,
+        CollisionExit,
+        TriggerEnter,
+        TriggerExit,
+        Count
+    };
+
+    struct ContactEvent
+    {
+        Entity owner;
+        Entity other;
+        ContactKind kind;
+    };
+
+    class IContainer
+    {
+    public:
+        virtual ~IContainer() = default;
+        virtual void Delete(std::pmr::memory_resource* aResource) = 0;
+        // A container of the same type for a forked registry, sharing the components with this one, or null if the
+        // components can't be shared
+        virtual IContainer* Fork(std::pmr::memory_resource* aResource) const = 0;
+        virtual void SetSignatureBit(mys::PagedVector<Signature>& someSignatures, Entity aBit) = 0;
+        virtual bool Contains(Entity aEntity) const = 0;
+        virtual size_t Size() const = 0;
+        virtual Entity& DenseFront() = 0;
+        virtual Entity& DenseBack() = 0;
+        virtual void Destroy(Entity aEntity) = 0;
 
         virtual void Update(mys::UpdateContext& anUpdateContext) = 0;
+        virtual void Update(mys::UpdateContext& anUpdateContext, mys::ThreadPool& aPool) = 0;
         virtual void Start() = 0;
 
         virtual void OnCollisionEnter(Entity aOwner, Entity aEntering) = 0;
@@ -172,6 +1376,9 @@ namespace ecs
 
         virtual void OnTriggerEnter(Entity aOwner, Entity aEntering) = 0;
         virtual void OnTriggerExit(Entity aOwner, Entity aEntering) = 0;
+
+        // All events are of the given kind
+        virtual void OnContacts(ContactKind aKind, const ContactEvent* someEvents, size_t aCount) = 0;
     };
 
     namespace detail
@@ -203,442 +1410,1832 @@ namespace ecs
             static constexpr bool value = type::value;                                                  \
         };                                                                                              \
 
-        DEFINE_HAS_METHOD(Update);
-        DEFINE_HAS_METHOD(Create);
-        DEFINE_HAS_METHOD(Start);
+        DEFINE_HAS_METHOD(Update);
+        DEFINE_HAS_METHOD(Create);
+        DEFINE_HAS_METHOD(Start);
+
+        DEFINE_HAS_METHOD(OnCollisionEnter);
+        DEFINE_HAS_METHOD(OnCollisionExit);
+
+        DEFINE_HAS_METHOD(OnTriggerEnter);
+        DEFINE_HAS_METHOD(OnTriggerExit);
+    }
+
+    // Specialize as std::true_type for components whose Update only touches the component itself,
+    // Registry::Update then splits their update loop over a thread pool
+    template <typename T>
+    struct ParallelSafe : std::false_type
+    {};
+
+    template <typename T>
+    class Container final : public IContainer
+    {
+    public:
+        explicit Container(std::pmr::memory_resource* aResource = std::pmr::get_default_resource()) :
+            myTypes(aResource, aResource), myOnConstruct(aResource), myOnDestroy(aResource), myContactOrder(aResource)
+        {}
+
+        // Shares the components with anOther until either of them writes to them. Listeners, signals, the owning group
+        // and the signature bit are not carried over
+        Container(const Container& anOther) :
+            myTypes(anOther.myTypes), myOnConstruct(anOther.myOnConstruct.get_allocator()), myOnDestroy(anOther.myOnDestroy.get_allocator()),
+            myContactOrder(anOther.myOnConstruct.get_allocator())
+        {}
+
+        Container& operator=(const Container&) = delete;
+
+        // Null for components that can't be copied, a fork couldn't write to them without a copy of its own
+        IContainer* Fork(std::pmr::memory_resource* aResource) const override
+        {
+            if constexpr (std::is_copy_constructible_v<T>)
+                return new (aResource->allocate(sizeof(Container), alignof(Container))) Container(*this);
+            else
+                return nullptr;
+        }
+
+        void Delete(std::pmr::memory_resource* aResource) override
+        {
+            this->~Container();
+            aResource->deallocate(this, sizeof(Container), alignof(Container));
+        }
+
+        template <typename... Args>
+        ComponentRef<T> Emplace(Entity aEntity, Args&&... args)
+        {
+            ComponentRef<T> component = Types().Emplace(aEntity, std::forward<Args>(args)...);
+            if (mySignatures)
+                (*mySignatures)[EntityTraits::Index(aEntity)].Set(myBit);
+            if (myOnConstruct.empty() && (!mySignals || mySignals->construct.empty()))
+                return component;
+
+            // Groups first, so signal listeners already see the entity in them
+            for (Listener& listener : myOnConstruct)
+                listener.function(listener.instance, aEntity);
+            if (mySignals)
+                Emit(mySignals->construct, aEntity);
+
+            return Types().Get(aEntity); // Owning groups may have moved the component
+        }
+
+        // Components are taken from aFrom, pass a std::move_iterator to move them in
+        template <typename EntityIt, typename ComponentIt, typename = typename std::iterator_traits<ComponentIt>::iterator_category>
+        void Insert(EntityIt aFirst, EntityIt aLast, ComponentIt aFrom)
+        {
+            Types().Reserve(Types().Size() + std::distance(aFirst, aLast));
+            for (; aFirst != aLast; ++aFirst, ++aFrom)
+                Emplace(*aFirst, *aFrom);
+        }
+
+        template <typename EntityIt>
+        void Insert(EntityIt aFirst, EntityIt aLast, const T& aValue)
+        {
+            Types().Reserve(Types().Size() + std::distance(aFirst, aLast));
+            for (; aFirst != aLast; ++aFirst)
+                Emplace(*aFirst, aValue);
+        }
+
+        void Reserve(size_t aCapacity)
+        {
+            Types().Reserve(aCapacity);
+        }
+
+        ConstComponentRef<T> Get(Entity aEntity) const
+        {
+            return ReadTypes().Get(aEntity);
+        }
+
+        ComponentRef<T> Get(Entity aEntity)
+        {
+            return Types().Get(aEntity);
+        }
+
+        ecs::Entity GetEntityOf(T& someType)
+        {
+            ECS_ASSERT(Contains(someType));
+            return ReadTypes().DenseData()[ReadTypes().PositionOf(someType)];
+        }
+
+        template <typename Func>
+        void Sort(Func&& aComparator)
+        {
+            ECS_ASSERT(!Owned() && "Owned components are ordered by their group");
+            Types().Sort(aComparator);
+        }
+
+        template <typename U>
+        void SortAs(Container<U>& aContainer)
+        {
+            ECS_ASSERT(!Owned() && "Owned components are ordered by their group");
+            Types().SortAs(std::as_const(aContainer).DenseData(), aContainer.Size());
+        }
+
+        size_t Size() const override
+        {
+            return ReadTypes().Size();
+        }
+
+        bool Contains(T& someType)
+        {
+            return ReadTypes().PositionOf(someType) < ReadTypes().Size();
+        }
+
+        bool Contains(Entity aEntity) const override
+        {
+            //return aEntity < sparse_capacity && sparse[aEntity] < size && dense[sparse[aEntity]] == aEntity;
+            return ReadTypes().Contains(aEntity);
+        }
+
+        Entity& DenseFront() override
+        {
+            return Types().DenseFront();
+        }
+
+        Entity& DenseBack() override
+        {
+            return *(&Types().DenseFront() + Types().Size() - 1);
+        }
+
+        void Destroy(Entity aEntity) override
+        {
+            if (ReadTypes().Contains(aEntity))
+            {
+                if (mySignals)
+                    Emit(mySignals->destroy, aEntity);
+                for (Listener& listener : myOnDestroy)
+                    listener.function(listener.instance, aEntity);
+                Types().Remove(aEntity);
+                if (mySignatures)
+                    (*mySignatures)[EntityTraits::Index(aEntity)].Reset(myBit);
+            }
+        }
+
+        template <typename Writer>
+        void Save(Writer& aWriter) const
+        {
+            ReadTypes().Save(aWriter);
+        }
+
+        // Loads into an empty container that nothing listens to yet, and sets the signature bit of every loaded entity
+        template <typename Reader>
+        bool Load(Reader& aReader, const mys::PagedVector<Entity>& someEntities)
+        {
+            ECS_ASSERT(myOnConstruct.empty() && "Containers are loaded before groups are created");
+            if (!Types().Load(aReader, someEntities))
+                return false;
+            if (mySignatures)
+            {
+                const Entity* entities = ReadTypes().DenseData();
+                for (size_t i = 0; i < ReadTypes().Size(); ++i)
+                    (*mySignatures)[EntityTraits::Index(entities[i])].Set(myBit);
+            }
+            return true;
+        }
+
+        uint64_t Hash() const
+        {
+            return ReadTypes().Hash();
+        }
+
+        bool WrittenSince(Version aVersion) const
+        {
+            return ReadTypes().WrittenSince(aVersion);
+        }
+
+        template <typename Writer>
+        void SaveDelta(const Container& aBaseline, Writer& aWriter) const
+        {
+            ReadTypes().SaveDelta(aBaseline.ReadTypes(), aWriter);
+        }
+
+        // Applies what SparseSet::SaveDelta wrote. Components are added and removed through Emplace and Destroy, so
+        // signatures and groups follow along. Stops and returns false at the first run, entity or component that
+        // doesn't fit someEntities and this set, components are only added to entities alive there
+        template <typename Reader>
+        bool ApplyDelta(Reader& aReader, const mys::PagedVector<Entity>& someEntities)
+        {
+            auto alive = [&someEntities](Entity aEntity)
+            {
+                const Entity index = EntityTraits::Index(aEntity);
+                return index < someEntities.size() && someEntities[index] == aEntity;
+            };
+
+            for (Entity run = detail::ReadRunLength(aReader); run; run = detail::ReadRunLength(aReader))
+            {
+                if (run > detail::RunLength)
+                    return false;
+                for (Entity i = 0; i < run; ++i)
+                    Destroy(detail::ReadValue<Entity>(aReader));
+            }
+
+            std::array<Entity, detail::RunLength> added;
+            for (Entity run = detail::ReadRunLength(aReader); run; run = detail::ReadRunLength(aReader))
+            {
+                if (run > detail::RunLength)
+                    return false;
+                aReader.Read(added.data(), run * sizeof(Entity));
+                for (Entity i = 0; i < run; ++i)
+                {
+                    if (!alive(added[i]) || ReadTypes().Contains(added[i]))
+                        return false;
+                    if constexpr (!Serializer<T>::Bulk)
+                        Emplace(added[i], Serializer<T>::Load(aReader));
+                    else if constexpr (IsTag<T>)
+                        Emplace(added[i]);
+                    else
+                        Emplace(added[i], detail::ReadValue<T>(aReader));
+                }
+            }
+
+            for (Entity run = detail::ReadRunLength(aReader); run; run = detail::ReadRunLength(aReader))
+            {
+                if (run > detail::RunLength)
+                    return false;
+                for (Entity i = 0; i < run; ++i)
+                {
+                    const Entity entity = detail::ReadValue<Entity>(aReader);
+                    if (!ReadTypes().Contains(entity))
+                        return false;
+                    if constexpr (!Serializer<T>::Bulk)
+                        Types().Get(entity) = Serializer<T>::Load(aReader);
+                    else
+                    {
+                        T component = Types().Get(entity);
+                        if (!detail::ReadXorDelta(aReader, &component, sizeof(T)))
+                            return false;
+                        Types().Get(entity) = component;
+                    }
+                    Updated(entity);
+                }
+            }
+            return !detail::ReadFailed(aReader);
+        }
+
+        // Keeps the bit of this type up to date in the registry's signatures
+        void SetSignatureBit(mys::PagedVector<Signature>& someSignatures, Entity aBit) override
+        {
+            mySignatures = &someSignatures;
+            myBit = aBit;
+        }
+
+        Entity SignatureBit() const
+        {
+            return myBit;
+        }
+
+        const mys::PagedVector<Signature>* Signatures() const
+        {
+            return mySignatures;
+        }
+
+        // Copies the components still shared with a forked registry on this thread, so workers can write to them
+        void Unshare()
+        {
+            Types().Unshare();
+        }
+
+        Entity* DenseData()
+        {
+            return Types().DenseData();
+        }
+
+        const Entity* DenseData() const
+        {
+            return ReadTypes().DenseData();
+        }
+
+        ComponentRef<T> At(Entity aPosition)
+        {
+            SparseSet<T>& types = Types();
+            types.Touch(aPosition, aPosition + 1);
+            return types[aPosition];
+        }
+
+        ConstComponentRef<T> At(Entity aPosition) const
+        {
+            return ReadTypes()[aPosition];
+        }
+
+        // Doesn't stamp the change version, callers touch the part of the chunk they write to
+        T* Chunk(Entity aPosition, size_t& aCount)
+        {
+            return Types().Chunk(aPosition, aCount);
+        }
+
+        const T* Chunk(Entity aPosition, size_t& aCount) const
+        {
+            return ReadTypes().Chunk(aPosition, aCount);
+        }
+
+        Version ChunkVersion(Entity aPosition) const
+        {
+            return ReadTypes().ChunkVersion(aPosition);
+        }
+
+        void Touch(Entity aFirst, Entity aLast)
+        {
+            Types().Touch(aFirst, aLast);
+        }
+
+        template <auto Member>
+        auto Field()
+        {
+            SparseSet<T>& types = Types();
+            types.Touch(0, static_cast<Entity>(types.Size()));
+            return mys::Span<typename mys::MemberTraits<decltype(Member)>::FieldType>{ types.template Field<Member>(), types.Size() };
+        }
+
+        template <auto Member>
+        auto Field() const
+        {
+            const SparseSet<T>& types = ReadTypes();
+            return mys::Span<const typename mys::MemberTraits<decltype(Member)>::FieldType>{ types.template Field<Member>(), types.Size() };
+        }
+
+        Entity DenseIndex(Entity aEntity) const
+        {
+            return ReadTypes().DenseIndex(aEntity);
+        }
+
+        void SwapDense(Entity aLhs, Entity aRhs)
+        {
+            Types().SwapDense(aLhs, aRhs);
+        }
+
+        // Construct listeners run after the component is added, destroy listeners before it is removed
+        void Connect(Listener anOnConstruct, Listener anOnDestroy)
+        {
+            myOnConstruct.push_back(anOnConstruct);
+            myOnDestroy.push_back(anOnDestroy);
+        }
+
+        // Signals are the registry's public counterpart of the group listeners. Construct runs after the group
+        // listeners, destroy before them, so both see the component and the groups it is in. The registry owns them
+        void SetSignals(detail::Signals* someSignals)
+        {
+            mySignals = someSignals;
+        }
+
+        // Called by the registry after Patch or Replace changed the component
+        void Updated(Entity aEntity)
+        {
+            if (mySignals)
+                Emit(mySignals->update, aEntity);
+        }
+
+        void Own(IGroup* aGroup)
+        {
+            ECS_ASSERT(!myOwner && "Component is already owned by another group");
+            myOwner = aGroup;
+        }
+
+        bool Owned() const
+        {
+            return myOwner;
+        }
+
+        void Update(mys::UpdateContext& anUpdateContext) override
+        {
+            if constexpr (detail::HasUpdate<T, void(mys::UpdateContext&)>::value)
+            {
+                SparseSet<T>& types = Types();
+                types.Touch(0, static_cast<Entity>(types.Size()));
+                for (Entity i = 0; i < types.Size(); ++i)
+                    types[i].Update(anUpdateContext);
+            }
+        }
+
+        void Update(mys::UpdateContext& anUpdateContext, mys::ThreadPool& aPool) override
+        {
+            if constexpr (detail::HasUpdate<T, void(mys::UpdateContext&)>::value && ParallelSafe<T>::value)
+            {
+                SparseSet<T>& types = Types();
+                types.Unshare();
+                types.Touch(0, static_cast<Entity>(types.Size()));
+                const size_t grain = (std::max)(size_t(64), types.Size() / (aPool.ThreadCount() * 4));
+                aPool.ParallelFor(types.Size(), grain, [&types, &anUpdateContext](size_t aBegin, size_t anEnd)
+                {
+                    for (size_t i = aBegin; i < anEnd; ++i)
+                        types[static_cast<Entity>(i)].Update(anUpdateContext);
+                });
+            }
+            else
+                Update(anUpdateContext);
+        }
+
+        void Start() override
+        {
+            if constexpr (detail::HasStart<T, void(void)>::value)
+            {
+                SparseSet<T>& types = Types();
+                types.Touch(0, static_cast<Entity>(types.Size()));
+                for (Entity i = 0; i < types.Size(); ++i)
+                    types[i].Start();
+            }
+        }
+
+        void OnCollisionEnter(Entity aOwner, Entity aEntering) override
+        {
+            if constexpr (detail::HasOnCollisionEnter<T, void(Entity)>::value)
+            {
+                Types().Get(aOwner).OnCollisionEnter(aEntering);
+                /*for (Entity i = 0; i < myTypes.Size(); ++i)
+                    myTypes[i].OnCollisionEnter(aEntity);*/
+            }
+        }
+
+        void OnCollisionExit(Entity aOwner, Entity aExiting) override
+        {
+            if constexpr (detail::HasOnCollisionExit<T, void(Entity)>::value)
+            {
+                Types().Get(aOwner).OnCollisionExit(aExiting);
+            }
+        }
+
+        void OnTriggerEnter(Entity aOwner, Entity aEntering) override
+        {
+            if constexpr (detail::HasOnTriggerEnter<T, void(Entity)>::value)
+            {
+                Types().Get(aOwner).OnTriggerEnter(aEntering);
+            }
+        }
+
+        void OnTriggerExit(Entity aOwner, Entity aExiting) override
+        {
+            if constexpr (detail::HasOnTriggerExit<T, void(Entity)>::value)
+            {
+                Types().Get(aOwner).OnTriggerExit(aExiting);
+            }
+        }
+
+        // Events are dispatched in dense order so the components are visited front to back,
+        // events for the same component keep the order they were given in
+        void OnContacts(ContactKind aKind, const ContactEvent* someEvents, size_t aCount) override
+        {
+            // The order is kept for the next dispatch. A callback dispatching contacts itself finds it taken and
+            // starts an empty one
+            SparseSet<T>& types = Types();
+            std::pmr::vector<std::pair<Entity, size_t>> order(myContactOrder.get_allocator());
+            order.swap(myContactOrder);
+            order.clear();
+            order.reserve(aCount);
+            for (size_t i = 0; i < aCount; ++i)
+            {
+                if (types.Contains(someEvents[i].owner))
+                    order.push_back({ types.DenseIndex(someEvents[i].owner), i });
+            }
+            std::sort(order.begin(), order.end());
+
+            for (auto [index, event] : order)
+            {
+                const ContactEvent& contact = someEvents[event];
+
+                // A callback may have removed components of this type and moved the owner
+                if (index >= types.Size() || types.DenseData()[index] != contact.owner)
+                {
+                    if (!types.Contains(contact.owner))
+                        continue;
+                    index = types.DenseIndex(contact.owner);
+                }
+                types.Touch(index, index + 1);
+
+                switch (aKind)
+                {
+                case ContactKind::CollisionEnter:
+                    if constexpr (detail::HasOnCollisionEnter<T, void(Entity)>::value)
+                        types[index].OnCollisionEnter(contact.other);
+                    break;
+                case ContactKind::CollisionExit:
+                    if constexpr (detail::HasOnCollisionExit<T, void(Entity)>::value)
+                        types[index].OnCollisionExit(contact.other);
+                    break;
+                case ContactKind::TriggerEnter:
+                    if constexpr (detail::HasOnTriggerEnter<T, void(Entity)>::value)
+                        types[index].OnTriggerEnter(contact.other);
+                    break;
+                case ContactKind::TriggerExit:
+                    if constexpr (detail::HasOnTriggerExit<T, void(Entity)>::value)
+                        types[index].OnTriggerExit(contact.other);
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            order.clear();
+            if (order.capacity() > myContactOrder.capacity())
+                myContactOrder.swap(order);
+        }
+
+    private:
+        // Forked registries share the set until one of them writes to it, so only paths that may write take Types()
+        SparseSet<T>& Types()
+        {
+            return myTypes.Write();
+        }
+
+        const SparseSet<T>& ReadTypes() const
+        {
+            return myTypes.Read();
+        }
+
+        // Listeners may connect others while running, so the signal is walked by index
+        static void Emit(const std::pmr::vector<Listener>& aSignal, Entity aEntity)
+        {
+            for (size_t i = 0; i < aSignal.size(); ++i)
+                aSignal[i].function(aSignal[i].instance, aEntity);
+        }
+
+        //std::vector<std::shared_ptr<std::array<T, 1000>> mirror;
+        //std::vector<Entity> dense;
+        //std::vector<Entity> sparse;
+        detail::CopyOnWrite<SparseSet<T>> myTypes;
+        std::pmr::vector<Listener> myOnConstruct;
+        std::pmr::vector<Listener> myOnDestroy;
+        detail::Signals* mySignals = nullptr;
+        std::pmr::vector<std::pair<Entity, size_t>> myContactOrder;
+        IGroup* myOwner = nullptr;
+        mys::PagedVector<Signature>* mySignatures = nullptr;
+        Entity myBit = Signature::NoBit;
+    };
+
+    // Membership test of a view. It needs one signature lookup per entity, as long as every type in the view has a bit
+    struct SignatureFilter
+    {
+        const mys::PagedVector<Signature>* signatures = nullptr;
+        Signature include;
+        Signature exclude;
+
+        template <typename... Types, typename... Excludes>
+        SignatureFilter(const std::tuple<Container<Types>*...>& someTypes, const std::tuple<Container<Excludes>*...>& someExcludes)
+        {
+            bool complete = true;
+            auto add = [&complete, this](auto* aContainer, Signature& aMask)
+            {
+                if (aContainer->SignatureBit() == Signature::NoBit)
+                    complete = false;
+                else
+                {
+                    aMask.Set(aContainer->SignatureBit());
+                    signatures = aContainer->Signatures();
+                }
+            };
+            std::apply([&add, this](auto* ...container) { (add(container, include), ...); }, someTypes);
+            std::apply([&add, this](auto* ...container) { (add(container, exclude), ...); }, someExcludes);
+            if (!complete)
+                signatures = nullptr;
+        }
+
+        bool Active() const
+        {
+            return signatures != nullptr;
+        }
+
+        bool Matches(Entity aEntity) const
+        {
+            return (*signatures)[EntityTraits::Index(aEntity)].Matches(include, exclude);
+        }
+    };
+
+    // Container a view reads T from, the same one for T and const T
+    template <typename T>
+    using ViewContainer = Container<std::remove_const_t<T>>;
+
+    namespace detail
+    {
+        template <typename T>
+        struct ViewRefOf
+        {
+            using Type = ComponentRef<T>;
+        };
+
+        template <typename T>
+        struct ViewRefOf<const T>
+        {
+            using Type = ConstComponentRef<T>;
+        };
+    }
+
+    // What a view hands out for T. Views of const T only read, so they neither stamp the change version nor make a
+    // forked registry copy the components
+    template <typename T>
+    using ViewRef = typename detail::ViewRefOf<T>::Type;
+
+    namespace detail
+    {
+        template <typename T>
+        ViewRef<T> ViewGet(ViewContainer<T>& aContainer, Entity aEntity)
+        {
+            if constexpr (std::is_const_v<T>)
+                return std::as_const(aContainer).Get(aEntity);
+            else
+                return aContainer.Get(aEntity);
+        }
+    }
+
+    template <typename It>
+    class IIterator
+    {
+    public:
+        IIterator(It aBegin, It aEnd) : myBegin(aBegin), myEnd(aEnd)
+        {}
+
+        It begin()
+        {
+            return myBegin;
+        }
+
+        It end()
+        {
+            return myEnd;
+        }
+
+    private:
+        It myBegin;
+        It myEnd;
+    };
+
+    template <typename, typename>
+    class TypeViewIterator;
+
+    // Walks the dense array of the driving container and skips entities missing from the others.
+    // The driver itself is never tested, it holds every entity it walks over.
+    template <typename... Types, typename... Excludes>
+    class TypeViewIterator<TList<Types...>, TList<Excludes...>>
+    {
+    public:
+        using ValueType = Entity;
+        using PointerType = const Entity*;
+        using ReferenceType = const Entity&;
+    public:
+
+        TypeViewIterator(const TypeViewIterator&) = default;
+        TypeViewIterator(TypeViewIterator&&) = default;
+
+        TypeViewIterator(const Entity* aEntity, const Entity* aEnd, const std::tuple<ViewContainer<Types>*...>& someContainer, const std::tuple<ViewContainer<Excludes>*...>& someExcludes, size_t aDriver, const SignatureFilter& aFilter) :
+            it(aEntity), end(aEnd), arr(someContainer), excludes(someExcludes), driver(aDriver), filter(aFilter)
+        {
+            while (it != end && !Valid(*it))
+                ++it;
+        }
+
+        PointerType operator->()
+        {
+            return it;
+        }
+
+        ReferenceType operator*()
+        {
+            return *it;
+        }
+
+        bool operator!=(const TypeViewIterator& aRhs) const
+        {
+            return it != aRhs.it;
+        }
+
+        bool operator==(const TypeViewIterator& aRhs) const
+        {
+            return it == aRhs.it;
+        }
+
+        inline TypeViewIterator& operator++()
+        {
+            while (++it != end && !Valid(*it));
+
+            return *this;
+        }
+
+        inline TypeViewIterator operator++(int)
+        {
+            TypeViewIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        inline std::tuple<ViewContainer<Types>*...>& Tuple()
+        {
+            return arr;
+        }
+
+        bool Valid(Entity aEntity) const
+        {
+            if (filter.Active())
+                return filter.Matches(aEntity);
+            return Included(aEntity, std::index_sequence_for<Types...>{}) && !Excluded(aEntity);
+        }
+
+    private:
+        template <size_t... I>
+        bool Included(Entity aEntity, std::index_sequence<I...>) const
+        {
+            return ((I == driver || std::get<I>(arr)->Contains(aEntity)) && ...);
+        }
+
+        bool Excluded(Entity aEntity) const
+        {
+            if constexpr (sizeof...(Excludes) > 0)
+                return std::apply([aEntity](auto* ...container) { return (container->Contains(aEntity) || ...); }, excludes);
+            else
+                return false;
+        }
+
+        const Entity* it;
+        const Entity* end;
+        std::tuple<ViewContainer<Types>*...> arr;
+        std::tuple<ViewContainer<Excludes>*...> excludes;
+        size_t driver;
+        SignatureFilter filter;
+    };
+
+    template <typename, typename>
+    class TypeViewEachIterator;
+
+    template <typename... Types, typename... Excludes>
+    class TypeViewEachIterator<TList<Types...>, TList<Excludes...>>
+    {
+    private:
+        using IteratorType = TypeViewIterator<TList<Types...>, TList<Excludes...>>;
+    public:
+        TypeViewEachIterator(IteratorType&& aIterator) : it(std::move(aIterator))
+        {}
+
+        auto operator*()
+        {
+            return Dereference(typename detail::PayloadIndices<Types...>::Sequence{});
+        }
+
+        bool operator!=(const TypeViewEachIterator& aRhs) const
+        {
+            return it != aRhs.it;
+        }
+
+        bool operator==(const TypeViewEachIterator& aRhs) const
+        {
+            return it == aRhs.it;
+        }
+
+        inline TypeViewEachIterator& operator++()
+        {
+            ++it;
+            return *this;
+        }
+
+        inline TypeViewEachIterator operator++(int)
+        {
+            TypeViewEachIterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+    private:
+        template <size_t... I>
+        std::tuple<Entity, ViewRef<std::tuple_element_t<I, std::tuple<Types...>>>...> Dereference(std::index_sequence<I...>)
+        {
+            const Entity entity = *it;
+            return std::tuple<Entity, ViewRef<std::tuple_element_t<I, std::tuple<Types...>>>...>(entity,
+                detail::ViewGet<std::tuple_element_t<I, std::tuple<Types...>>>(*std::get<I>(it.Tuple()), entity)...);
+        }
+
+        IteratorType it;
+    };
+
+    template <typename T1, typename T2>
+    class TypeView;
+
+    template <typename... Types, typename... Excludes>
+    class TypeView<TList<Types...>, TList<Excludes...>>
+    {
+    public:
+        using Iterator = TypeViewIterator<TList<Types...>, TList<Excludes...>>;
+        using EachIterator = TypeViewEachIterator<TList<Types...>, TList<Excludes...>>;
+        using EachIteratorWrapper = IIterator<TypeViewEachIterator<TList<Types...>, TList<Excludes...>>>;
+    public:
+
+        TypeView(const std::tuple<ViewContainer<Types>*...>& someTypes, const std::tuple<ViewContainer<Excludes>*...>& someExcludes) :
+            excludes(someExcludes),
+            types(someTypes),
+            driver(Smallest(std::index_sequence_for<Types...>{})),
+            filter(someTypes, someExcludes),
+            since(0)
+        {}
+
+        // Limits Each and ParallelEach to components of T, the first type by default, in chunks written to after
+        // aVersion. T drives the view from then on so whole chunks are skipped, and as the stamps are per chunk the
+        // unchanged neighbours of a changed component come along. Iterators still walk every entity
+        template <typename T = std::tuple_element_t<0, std::tuple<Types...>>>
+        TypeView& ChangedSince(Version aVersion)
+        {
+            constexpr size_t index = detail::IndexOf<std::remove_const_t<T>, std::remove_const_t<Types>...>();
+            static_assert(index < sizeof...(Types), "Changes can only be tracked for a type the view includes");
+            driver = index;
+            since = aVersion;
+            return *this;
+        }
 
-        DEFINE_HAS_METHOD(OnCollisionEnter);
-        DEFINE_HAS_METHOD(OnCollisionExit);
+        // True if aEntity has every type of the view and none of the excluded ones
+        bool Contains(Entity aEntity) const
+        {
+            return IncludedBy<sizeof...(Types)>(aEntity, std::index_sequence_for<Types...>{}) && !Excluded(aEntity);
+        }
 
-        DEFINE_HAS_METHOD(OnTriggerEnter);
-        DEFINE_HAS_METHOD(OnTriggerExit);
-    }
+        // Calls aFunction(entity, components...) for a single entity, which has to be in the view
+        template <typename Func>
+        void Apply(Entity aEntity, Func&& aFunction)
+        {
+            ECS_ASSERT(Contains(aEntity) && "Entity is not in the view");
+            InvokeAll(aFunction, aEntity, typename detail::PayloadIndices<Types...>::Sequence{});
+        }
 
-    template <typename T>
-    class Container : public IContainer
-    {
-    public:
+        Iterator begin()
+        {
+            const Entity* first = DriverData();
+            return Iterator(first, first + DriverSize(), types, excludes, driver, filter);
+        }
 
-        template <typename... Args>
-        T& Emplace(Entity aEntity, Args&&... args)
+        Iterator end()
         {
-            return myTypes.Emplace(aEntity, args...);
+            const Entity* last = DriverData() + DriverSize();
+            return Iterator(last, last, types, excludes, driver, filter);
         }
 
-        const T& Get(Entity aEntity) const
+        EachIteratorWrapper Each()
         {
-            return myTypes.Get(aEntity);
+            return EachIteratorWrapper(EachIterator(begin()), EachIterator(end()));
         }
 
-        T& Get(Entity aEntity)
+        // Span over one field of every component of an SoA type, in the container's packed order.
+        // Only single type views without excludes line up with the packed order
+        template <auto Member>
+        auto Field()
         {
-            return myTypes.Get(aEntity);
+            static_assert(sizeof...(Types) == 1 && sizeof...(Excludes) == 0, "Fields can only be read from a view of a single type");
+            if constexpr (std::is_const_v<std::tuple_element_t<0, std::tuple<Types...>>>)
+                return std::as_const(*std::get<0>(types)).template Field<Member>();
+            else
+                return std::get<0>(types)->template Field<Member>();
         }
 
-        ecs::Entity GetEntityOf(T& someType)
+        // Calls aFunction(entity, components...) for every entity in the view, tags are filtered on but not passed. The loop
+        // is instantiated per driving component, so the driver is read straight from its packed array and never tested for membership.
+        template <typename Func>
+        void Each(Func&& aFunction)
         {
-            ECS_ASSERT(Contains(someType));
-            return *(&myTypes.DenseFront() + (&someType - &myTypes.Front()));
+            Dispatch([this, &aFunction](auto aDriver)
+            {
+                EachDriven<decltype(aDriver)::value>(aFunction, 0, std::get<decltype(aDriver)::value>(types)->Size());
+            }, std::index_sequence_for<Types...>{});
         }
 
+        // Same as Each(aFunction) but split over the pool in chunks of the driving container. Chunks start at an
+        // element that starts a cache line of the driver's components, so workers writing to the component they are
+        // handed never share a line. Components of the other types are fetched by entity and may still share one.
+        // Components a forked registry still shares are copied on the calling thread before the workers start.
         template <typename Func>
-        void Sort(Func&& aComparator)
+        void ParallelEach(mys::ThreadPool& aPool, Func&& aFunction, size_t aGrainSize = 1024)
         {
+            Unshare(std::index_sequence_for<Types...>{});
+            Dispatch([this, &aPool, &aFunction, aGrainSize](auto aDriver)
+            {
+                constexpr size_t Driver = decltype(aDriver)::value;
+                size_t first = 0;
+                const size_t step = LineStep<Driver>(first);
+                const size_t grain = (((std::max)(aGrainSize, size_t(1)) + step - 1) / step) * step;
+
+                // Shifting the range by shift puts every chunk boundary on first plus a multiple of grain
+                const size_t shift = (grain - first % grain) % grain;
+                aPool.ParallelFor(std::get<Driver>(types)->Size() + shift, grain, [this, &aFunction, shift](size_t aBegin, size_t anEnd)
+                {
+                    EachDriven<Driver>(aFunction, aBegin > shift ? aBegin - shift : 0, anEnd - shift);
+                });
+            }, std::index_sequence_for<Types...>{});
+        }
 
+    private:
+        template <size_t... I>
+        size_t Smallest(std::index_sequence<I...>) const
+        {
+            size_t result = 0;
+            size_t size = std::get<0>(types)->Size();
+            ((std::get<I>(types)->Size() < size ? (size = std::get<I>(types)->Size(), result = I) : 0), ...);
+            return result;
         }
 
-        size_t Size() const override
+        // Types only read from are left shared
+        template <size_t... I>
+        void Unshare(std::index_sequence<I...>)
         {
-            return myTypes.Size();
+            ((std::is_const_v<Types> ? void() : std::get<I>(types)->Unshare()), ...);
         }
 
-        bool Contains(T& someType)
+        template <typename Func, size_t... I>
+        void Dispatch(Func&& aFunction, std::index_sequence<I...>)
         {
-            return (&someType - &myTypes.Front()) < myTypes.Size();
+            ((driver == I ? (aFunction(std::integral_constant<size_t, I>{}), true) : false) || ...);
         }
 
-        bool Contains(Entity aEntity) const override
+        const Entity* DriverData()
         {
-            //return aEntity < sparse_capacity && sparse[aEntity] < size && dense[sparse[aEntity]] == aEntity;
-            return myTypes.Contains(aEntity);
+            const Entity* data = nullptr;
+            Dispatch([this, &data](auto aDriver) { data = std::as_const(*std::get<decltype(aDriver)::value>(types)).DenseData(); }, std::index_sequence_for<Types...>{});
+            return data;
         }
 
-        Entity& DenseFront() override
+        size_t DriverSize()
         {
-            return myTypes.DenseFront();
+            size_t size = 0;
+            Dispatch([this, &size](auto aDriver) { size = std::get<decltype(aDriver)::value>(types)->Size(); }, std::index_sequence_for<Types...>{});
+            return size;
         }
 
-        Entity& DenseBack() override
+        template <size_t Driver, size_t... I>
+        bool IncludedBy(Entity aEntity, std::index_sequence<I...>) const
         {
-            return *(&myTypes.DenseFront() + myTypes.Size() - 1);
+            return ((I == Driver || std::get<I>(types)->Contains(aEntity)) && ...);
         }
 
-        void Destroy(Entity aEntity) override
+        bool Excluded(Entity aEntity) const
         {
-            if (myTypes.Contains(aEntity))
-                myTypes.Remove(aEntity);
+            if constexpr (sizeof...(Excludes) > 0)
+                return std::apply([aEntity](auto* ...container) { return (container->Contains(aEntity) || ...); }, excludes);
+            else
+                return false;
         }
 
-        void Update(mys::UpdateContext& anUpdateContext) override
+        template <size_t Driver>
+        using DriverType = std::tuple_element_t<Driver, std::tuple<Types...>>;
+
+        // Number of driver elements from one that starts a cache line to the next, with the first such element in
+        // aFirst. Pages of stable storage start on a line, so the count fits every page. The fields of SoA components
+        // are split every 64 elements, which puts the boundaries on whole lines of each field array.
+        template <size_t Driver>
+        size_t LineStep(size_t& aFirst)
         {
-            if constexpr (detail::HasUpdate<T, void(mys::UpdateContext&)>::value)
+            constexpr size_t cacheLine = 64;
+            aFirst = 0;
+            if constexpr (SparseSet<std::remove_const_t<DriverType<Driver>>>::IsSoA || IsTag<DriverType<Driver>>)
+                return cacheLine;
+            else
             {
-                for (Entity i = 0; i < myTypes.Size(); ++i)
-                    myTypes[i].Update(anUpdateContext);
+                constexpr size_t elementSize = sizeof(DriverType<Driver>);
+                constexpr size_t step = cacheLine / std::gcd(elementSize, cacheLine);
+                auto* driver = std::get<Driver>(types);
+                if (driver->Size() == 0)
+                    return step;
+
+                size_t count = 0;
+                const uintptr_t address = reinterpret_cast<uintptr_t>(std::as_const(*driver).Chunk(0, count));
+                while (aFirst < step && (address + aFirst * elementSize) % cacheLine != 0)
+                    ++aFirst;
+                // No element starts a line when the array itself is less aligned than the elements need
+                if (aFirst == step)
+                    aFirst = 0;
+                return step;
             }
         }
 
-        void Start() override
+        template <size_t I, size_t Driver>
+        ViewRef<std::tuple_element_t<I, std::tuple<Types...>>> Fetch(Entity aEntity, ViewRef<DriverType<Driver>> aDriven)
         {
-            if constexpr (detail::HasStart<T, void(void)>::value)
-            {
-                for (Entity i = 0; i < myTypes.Size(); ++i)
-                    myTypes[i].Start();
-            }
+            if constexpr (I == Driver)
+                return aDriven;
+            else
+                return detail::ViewGet<std::tuple_element_t<I, std::tuple<Types...>>>(*std::get<I>(types), aEntity);
         }
 
-        void OnCollisionEnter(Entity aOwner, Entity aEntering) override
+        template <typename Func, size_t... I>
+        void InvokeAll(Func& aFunction, Entity aEntity, std::index_sequence<I...>)
         {
-            if constexpr (detail::HasOnCollisionEnter<T, void(Entity)>::value)
-            {
-                myTypes.Get(aOwner).OnCollisionEnter(aEntering);
-                /*for (Entity i = 0; i < myTypes.Size(); ++i)
-                    myTypes[i].OnCollisionEnter(aEntity);*/
-            }
+            aFunction(aEntity, detail::ViewGet<std::tuple_element_t<I, std::tuple<Types...>>>(*std::get<I>(types), aEntity)...);
         }
 
-        void OnCollisionExit(Entity aOwner, Entity aExiting) override
+        template <size_t Driver, typename Func, size_t... I>
+        void Invoke(Func& aFunction, Entity aEntity, ViewRef<DriverType<Driver>> aDriven, std::index_sequence<I...>)
         {
-            if constexpr (detail::HasOnCollisionExit<T, void(Entity)>::value)
+            aFunction(aEntity, Fetch<I, Driver>(aEntity, aDriven)...);
+        }
+
+        template <size_t Driver, typename Func>
+        void Visit(Func& aFunction, Entity aEntity, ViewRef<DriverType<Driver>> aDriven)
+        {
+            if constexpr (sizeof...(Types) > 1 || sizeof...(Excludes) > 0)
             {
-                myTypes.Get(aOwner).OnCollisionExit(aExiting);
+                if (filter.Active() ? !filter.Matches(aEntity) : (!IncludedBy<Driver>(aEntity, std::index_sequence_for<Types...>{}) || Excluded(aEntity)))
+                    return;
             }
+            Invoke<Driver>(aFunction, aEntity, aDriven, typename detail::PayloadIndices<Types...>::Sequence{});
         }
 
-        void OnTriggerEnter(Entity aOwner, Entity aEntering) override
+        // Skips the chunks of the driver that weren't written to since the version given to ChangedSince
+        template <size_t Driver, typename Func>
+        void EachDriven(Func& aFunction, size_t aBegin, size_t anEnd)
         {
-            if constexpr (detail::HasOnTriggerEnter<T, void(Entity)>::value)
+            if (!since)
+                return EachRange<Driver>(aFunction, aBegin, anEnd);
+
+            constexpr size_t Chunk = SparseSet<std::remove_const_t<DriverType<Driver>>>::VersionChunk;
+            auto* driver = std::get<Driver>(types);
+            for (size_t begin = aBegin; begin < anEnd;)
             {
-                myTypes.Get(aOwner).OnTriggerEnter(aEntering);
+                const size_t end = (std::min)(anEnd, (begin / Chunk + 1) * Chunk);
+                if (driver->ChunkVersion(static_cast<Entity>(begin)) > since)
+                    EachRange<Driver>(aFunction, begin, end);
+                begin = end;
             }
         }
 
-        void OnTriggerExit(Entity aOwner, Entity aExiting) override
+        // Walks the driver one contiguous chunk at a time, which is the whole range unless it uses stable storage.
+        // A const driver is read through the const container, so nothing is stamped
+        template <size_t Driver, typename Func>
+        void EachRange(Func& aFunction, size_t aBegin, size_t anEnd)
         {
-            if constexpr (detail::HasOnTriggerExit<T, void(Entity)>::value)
+            using Driven = std::remove_const_t<DriverType<Driver>>;
+            constexpr bool readOnly = std::is_const_v<DriverType<Driver>>;
+            auto* driver = std::get<Driver>(types);
+            const Entity* entities = std::as_const(*driver).DenseData();
+            if constexpr (SparseSet<Driven>::IsSoA || IsTag<Driven>)
+            {
+                for (size_t i = aBegin; i < anEnd; ++i)
+                {
+                    if constexpr (readOnly)
+                        Visit<Driver>(aFunction, entities[i], std::as_const(*driver).At(static_cast<Entity>(i)));
+                    else
+                        Visit<Driver>(aFunction, entities[i], driver->At(static_cast<Entity>(i)));
+                }
+            }
+            else
             {
-                myTypes.Get(aOwner).OnTriggerExit(aExiting);
+                for (size_t begin = aBegin; begin < anEnd;)
+                {
+                    size_t count = 0;
+                    DriverType<Driver>* components;
+                    if constexpr (readOnly)
+                        components = std::as_const(*driver).Chunk(static_cast<Entity>(begin), count);
+                    else
+                        components = driver->Chunk(static_cast<Entity>(begin), count);
+                    count = (std::min)(count, anEnd - begin);
+                    if constexpr (!readOnly)
+                        driver->Touch(static_cast<Entity>(begin), static_cast<Entity>(begin + count));
+
+                    for (size_t i = 0; i < count; ++i)
+                        Visit<Driver>(aFunction, entities[begin + i], components[i]);
+                    begin += count;
+                }
             }
         }
 
-    private:
-        //std::vector<std::shared_ptr<std::array<T, 1000>> mirror;
-        //std::vector<Entity> dense;
-        //std::vector<Entity> sparse;
-        SparseSet<T> myTypes;
+        std::tuple<ViewContainer<Types>*...> types;
+        std::tuple<ViewContainer<Excludes>*...> excludes;
+        size_t driver;
+        SignatureFilter filter;
+        Version since;
     };
 
-    template <typename It>
-    class IIterator
+    template <typename, typename, typename>
+    class GroupHandler;
+
+    // Keeps the owned containers sorted so that the first Size() elements of each are the group members, in the same order
+    template <typename... Owned, typename... Gets, typename... Excludes>
+    class GroupHandler<TList<Owned...>, TList<Gets...>, TList<Excludes...>> : public IGroup
     {
     public:
-        IIterator(It aBegin, It aEnd) : myBegin(aBegin), myEnd(aEnd)
-        {}
+        GroupHandler(const std::tuple<Container<Owned>*...>& someOwned, const std::tuple<Container<Gets>*...>& someGets, const std::tuple<Container<Excludes>*...>& someExcludes) :
+            owned(someOwned), gets(someGets), excludes(someExcludes), size(0)
+        {
+            static_assert(sizeof...(Owned) > 0, "A group has to own at least one component");
+            std::apply([this](auto* ...container)
+            {
+                (container->Own(this), ...);
+                (container->Connect({ this, &OnInclude }, { this, &OnDiscard }), ...);
+            }, owned);
 
-        It begin()
+            std::apply([this](auto* ...container)
+            {
+                (container->Connect({ this, &OnInclude }, { this, &OnDiscard }), ...);
+            }, gets);
+
+            std::apply([this](auto* ...container)
+            {
+                (container->Connect({ this, &OnDiscard }, { this, &OnUnexclude }), ...);
+            }, excludes);
+
+            // Pushing only swaps with slots that were already visited, so a single forward pass is enough
+            auto* lead = std::get<0>(owned);
+            for (size_t i = 0; i < lead->Size(); ++i)
+                MaybePush(lead->DenseData()[i], 0);
+        }
+
+        void Delete(std::pmr::memory_resource* aResource) override
         {
-            return myBegin;
+            this->~GroupHandler();
+            aResource->deallocate(this, sizeof(GroupHandler), alignof(GroupHandler));
         }
 
-        It end()
+        size_t Size() const
         {
-            return myEnd;
+            return size;
+        }
+
+        std::tuple<Container<Owned>*...>& OwnedContainers()
+        {
+            return owned;
+        }
+
+        std::tuple<Container<Gets>*...>& GetContainers()
+        {
+            return gets;
         }
 
     private:
-        It myBegin;
-        It myEnd;
+        static void OnInclude(void* aGroup, Entity aEntity)
+        {
+            static_cast<GroupHandler*>(aGroup)->MaybePush(aEntity, 0);
+        }
+
+        static void OnDiscard(void* aGroup, Entity aEntity)
+        {
+            static_cast<GroupHandler*>(aGroup)->MaybePop(aEntity);
+        }
+
+        // Runs before the excluded component is removed, so that one is still counted
+        static void OnUnexclude(void* aGroup, Entity aEntity)
+        {
+            static_cast<GroupHandler*>(aGroup)->MaybePush(aEntity, 1);
+        }
+
+        bool InGroup(Entity aEntity) const
+        {
+            auto* lead = std::get<0>(owned);
+            return lead->Contains(aEntity) && lead->DenseIndex(aEntity) < size;
+        }
+
+        void MaybePush(Entity aEntity, size_t someExcluded)
+        {
+            if (InGroup(aEntity))
+                return;
+
+            const bool included = std::apply([aEntity](auto* ...container) { return (container->Contains(aEntity) && ...); }, owned)
+                && std::apply([aEntity](auto* ...container) { return (container->Contains(aEntity) && ...); }, gets);
+
+            if (!included)
+                return;
+
+            if constexpr (sizeof...(Excludes) > 0)
+            {
+                const size_t excluded = std::apply([aEntity](auto* ...container) { return (size_t(container->Contains(aEntity)) + ...); }, excludes);
+                if (excluded != someExcluded)
+                    return;
+            }
+
+            std::apply([aEntity, this](auto* ...container) { (container->SwapDense(container->DenseIndex(aEntity), size), ...); }, owned);
+            ++size;
+        }
+
+        void MaybePop(Entity aEntity)
+        {
+            if (!InGroup(aEntity))
+                return;
+
+            --size;
+            std::apply([aEntity, this](auto* ...container) { (container->SwapDense(container->DenseIndex(aEntity), size), ...); }, owned);
+        }
+
+        std::tuple<Container<Owned>*...> owned;
+        std::tuple<Container<Gets>*...> gets;
+        std::tuple<Container<Excludes>*...> excludes;
+        size_t size;
     };
 
     template <typename, typename>
-    class TypeViewIterator;
+    class TypeGroupEachIterator;
 
-    template <typename... Types, typename... Excludes>
-    class TypeViewIterator<TList<Types...>, TList<Excludes...>>
+    template <typename... Owned, typename... Gets>
+    class TypeGroupEachIterator<TList<Owned...>, TList<Gets...>>
     {
     public:
-        using ValueType = Entity;
-        using PointerType = Entity*;
-        using ReferenceType = Entity&;
-    public:
+        TypeGroupEachIterator(Entity* someEntities, const std::tuple<Container<Owned>*...>& someOwned, const std::tuple<Container<Gets>*...>& someGets, size_t anIndex) :
+            entities(someEntities), owned(someOwned), gets(someGets), index(anIndex)
+        {}
 
-        TypeViewIterator(const TypeViewIterator&) = default;
-        TypeViewIterator(TypeViewIterator&&) = default;
+        std::tuple<Entity, ComponentRef<Owned>..., ComponentRef<Gets>...> operator*()
+        {
+            const Entity entity = entities[index];
+            return std::tuple<Entity, ComponentRef<Owned>..., ComponentRef<Gets>...>(entity, std::get<Container<Owned>*>(owned)->At(static_cast<Entity>(index))..., std::get<Container<Gets>*>(gets)->Get(entity)...);
+        }
 
-        TypeViewIterator(Entity* aEntity, std::tuple<Container<Types>*...> someContainer, std::tuple<Container<Excludes>*...> someExcludes, Entity* aEnd) :
-            it(aEntity), arr(std::move(someContainer)), excludes(std::move(someExcludes)), end(aEnd) {
-            while (it != end && !Valid(*it) && ++it != end);
+        bool operator!=(const TypeGroupEachIterator& aRhs)
+        {
+            return index != aRhs.index;
         }
 
-        PointerType operator->()
+        bool operator==(const TypeGroupEachIterator& aRhs)
         {
-            return it;
+            return index == aRhs.index;
         }
 
-        ReferenceType operator*()
+        inline TypeGroupEachIterator& operator++()
         {
-            return *it;
+            ++index;
+            return *this;
         }
 
-        bool operator!=(const TypeViewIterator& aRhs)
+    private:
+        Entity* entities;
+        std::tuple<Container<Owned>*...> owned;
+        std::tuple<Container<Gets>*...> gets;
+        size_t index;
+    };
+
+    template <typename, typename, typename>
+    class TypeGroup;
+
+    template <typename... Owned, typename... Gets, typename... Excludes>
+    class TypeGroup<TList<Owned...>, TList<Gets...>, TList<Excludes...>>
+    {
+    public:
+        using Handler = GroupHandler<TList<Owned...>, TList<Gets...>, TList<Excludes...>>;
+        using EachIterator = TypeGroupEachIterator<TList<Owned...>, TList<Gets...>>;
+        using EachIteratorWrapper = IIterator<EachIterator>;
+    public:
+        TypeGroup(Handler& aHandler) : handler(&aHandler)
+        {}
+
+        size_t Size() const
         {
-            return it != aRhs.it;
+            return handler->Size();
         }
 
-        bool operator==(const TypeViewIterator& aRhs)
+        Entity* begin()
         {
-            return it == aRhs.it;
+            return std::get<0>(handler->OwnedContainers())->DenseData();
         }
 
-        inline TypeViewIterator& operator++()
+        Entity* end()
         {
-            while (++it != end && !Valid(*it));
+            return begin() + Size();
+        }
 
-            return *this;
+        // Owned components are read in lockstep from the front of each container, no membership tests needed
+        EachIteratorWrapper Each()
+        {
+            return EachIteratorWrapper(EachIterator(begin(), handler->OwnedContainers(), handler->GetContainers(), 0), EachIterator(begin(), handler->OwnedContainers(), handler->GetContainers(), Size()));
         }
 
-        inline TypeViewIterator& operator++(int)
+        // Span over one field of an owned SoA type. Owned fields share the group's order, so index i of every
+        // span belongs to the same entity
+        template <auto Member>
+        auto Field()
         {
-            TypeViewIterator tmp = *this;
-            ++(*this);
-            return tmp;
+            using Type = typename mys::MemberTraits<decltype(Member)>::ClassType;
+            static_assert((std::is_same_v<Type, Owned> || ...), "Fields can only be read from owned types");
+            auto field = std::get<Container<Type>*>(handler->OwnedContainers())->template Field<Member>();
+            field.size = Size();
+            return field;
         }
 
-        inline std::tuple<Container<Types>*...>& Tuple()
+    private:
+        Handler* handler;
+    };
+
+    class Registry
+    {
+    public:
+        friend class EntityIterator;
+
+        // All storage of the registry, components included, is allocated from aResource. With a monotonic arena
+        // (std::pmr::monotonic_buffer_resource, optionally on top of mys::HugePageResource) the registry lives in
+        // one region that can be released at once after Clear or destruction
+        explicit Registry(std::pmr::memory_resource* aResource = std::pmr::get_default_resource()) :
+            myTable(aResource),
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            myEntityQueue(aResource),
+#endif
+            myEntityDestroyList(aResource),
+            myEntityDestroyQueue(aResource),
+            myContainers(aResource),
+            mySignals(aResource),
+            mySignedContainers(aResource),
+            myUnsignedContainers(aResource),
+            myHooks(MakeHooks(aResource, std::make_index_sequence<HookCount>{})),
+            myContacts(aResource),
+            myDispatchedContacts(aResource),
+            myContactBucket(aResource),
+            myGroups(aResource),
+            myOnRelease(aResource),
+            myResource(aResource)
+        {}
+
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+        ~Registry()
         {
-            return arr;
+            for (size_t i = 0; i < myOnRelease.size(); ++i)
+                myOnRelease[i].function(myOnRelease[i].instance, nullentity);
+            for (Entity i = 0; i < myGroups.Size(); ++i)
+                myGroups[i]->Delete(myResource);
+            for (Entity i = 0; i < myContainers.Size(); ++i)
+                myContainers[i]->Delete(myResource);
+            for (Entity i = 0; i < mySignals.Size(); ++i)
+            {
+                mySignals[i]->~Signals();
+                myResource->deallocate(mySignals[i], sizeof(detail::Signals), alignof(detail::Signals));
+            }
         }
 
-        bool Valid(Entity aEntity)
+        // Hands every allocation back to the resource, not just the components. Pages of the entity table a fork still
+        // shares are left to the fork
+        void Clear()
         {
-            bool types = std::apply([aEntity](auto* ...container) -> bool
+            for (Entity i = 0; i < myGroups.Size(); ++i)
+                myGroups[i]->Delete(myResource);
+            for (Entity i = 0; i < myContainers.Size(); ++i)
+                myContainers[i]->Delete(myResource);
+
+            Release(myTable.entities);
+            Release(myTable.pendingDestroy);
+            Release(myTable.destroyTimes);
+            Release(myTable.signatures);
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            myEntityQueue.Clear();
+#else
+            myFreeList = EntityTraits::IndexMask;
+#endif
+            Release(myEntityDestroyList);
+            myEntityDestroyQueue.Clear();
+            myClock = 0.0;
+            myStateHash = 0;
+            myContainers.Clear();
+            Release(mySignedContainers);
+            Release(myUnsignedContainers);
+            for (std::pmr::vector<IContainer*>& hook : myHooks)
+                Release(hook);
+            Release(myContacts);
+            Release(myDispatchedContacts);
+            Release(myContactBucket);
+            myGroups.Clear();
+        }
+
+        std::pmr::memory_resource* GetResource() const
+        {
+            return myResource;
+        }
+
+        // Starts a registry with the same entities and components that shares their storage with this one. Storage is
+        // copied per component type the first time either registry writes to it through Get, Emplace, Remove, a view
+        // or an update. That copies the type's whole sparse set, and its components too unless they are kept in
+        // pages, which only copy the pages written to. The entity table is copied per page as well, so the cost of
+        // the first write to a type grows with how many entities have it. Groups are not carried over. Pointers into components taken before a write may point into the other
+        // registry's copy afterwards. Returns null if a component type can't be copied
+        std::unique_ptr<Registry> Fork()
+        {
+            std::unique_ptr<Registry> fork = std::make_unique<Registry>(myResource);
+            fork->myTable = myTable;
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            fork->myEntityQueue = myEntityQueue;
+#else
+            fork->myFreeList = myFreeList;
+#endif
+            fork->myEntityDestroyList = myEntityDestroyList;
+            fork->myEntityDestroyQueue = myEntityDestroyQueue;
+            fork->myClock = myClock;
+            fork->myStateHash = myStateHash;
+            fork->myStateVersion = myStateVersion;
+            fork->myContacts = myContacts;
+            fork->myContactPhase = myContactPhase;
+
+            const Entity* ids = myContainers.DenseData();
+            for (Entity i = 0; i < myContainers.Size(); ++i)
             {
-                size_t contains = 0;
+                IContainer* copy = myContainers[i]->Fork(myResource);
+                if (!copy)
+                    return nullptr;
+                fork->myContainers.Emplace(ids[i], copy);
+            }
 
-                contains = (container->Contains(aEntity) + ...);
+            // Containers keep their position in the lists, so signature bits and hooks line up with this registry
+            auto forked = [this, &fork](IContainer* aContainer)
+            {
+                Entity i = 0;
+                while (myContainers[i] != aContainer)
+                    ++i;
+                return fork->myContainers[i];
+            };
+            for (IContainer* container : mySignedContainers)
+            {
+                IContainer* copy = forked(container);
+                copy->SetSignatureBit(fork->myTable.signatures, static_cast<Entity>(fork->mySignedContainers.size()));
+                fork->mySignedContainers.push_back(copy);
+            }
+            for (IContainer* container : myUnsignedContainers)
+                fork->myUnsignedContainers.push_back(forked(container));
+            for (size_t hook = 0; hook < HookCount; ++hook)
+            {
+                for (IContainer* container : myHooks[hook])
+                    fork->myHooks[hook].push_back(forked(container));
+            }
+            return fork;
+        }
 
-                return contains == sizeof...(Types);
-            }, arr);
+        // Writes the entities with their free list, the pending and timed destroys, the clock and the listed component
+        // types to aWriter, which only has to take Write(const void*, size_t). Component types are identified by their
+        // position in the list, so Restore has to be given the same types in the same order
+        template <typename... Components, typename Writer>
+        void Snapshot(Writer& aWriter) const
+        {
+            WriteSnapshotHeader<Components...>(aWriter, SnapshotHeader::SnapshotMagic);
 
+            const EntityTable& table = ReadTable();
+            detail::WriteValue(aWriter, static_cast<uint64_t>(table.entities.size()));
+            detail::WritePaged(aWriter, table.entities);
+            detail::WritePaged(aWriter, table.destroyTimes);
+            detail::WritePaged(aWriter, table.pendingDestroy);
+            SaveEntityQueues(aWriter);
 
-            if constexpr (sizeof...(Excludes) > 0)
+            (SaveContainer<Components>(aWriter), ...);
+        }
+
+        // Replaces the registry with a snapshot written by Snapshot<Components...>. Like Clear, every container and
+        // group is recreated, so handles to them have to be fetched again. Returns false and leaves the registry
+        // untouched if the snapshot was written for other types or another entity layout. A snapshot that turns out to
+        // be cut off part way, or to hold entities or components that don't fit together, also returns false but
+        // leaves the registry cleared
+        template <typename... Components, typename Reader>
+        bool Restore(Reader& aReader)
+        {
+            if (!ReadSnapshotHeader<Components...>(aReader, SnapshotHeader::SnapshotMagic))
+                return false;
+            const uint64_t count = detail::ReadValue<uint64_t>(aReader);
+            if (count > EntityTraits::IndexMask || detail::ReadFailed(aReader))
+                return false;
+
+            Clear();
+
+            EntityTable& table = WriteTable();
+            detail::ReadPaged(aReader, table.entities, count);
+            detail::ReadPaged(aReader, table.destroyTimes, count);
+            detail::ReadPaged(aReader, table.pendingDestroy, count);
+            table.signatures.resize(count);
+            if (!LoadEntityQueues(aReader, count) || !(GetContainer<Components>()->Load(aReader, std::as_const(table).entities) && ...))
+            {
+                Clear();
+                return false;
+            }
+            RememberState(StateHash<Components...>());
+            return true;
+        }
+
+        // Identifies the state of the entities and the listed component types. Components are hashed per entity and
+        // summed, so registries that only differ in the order of their packed arrays, such as one with groups, agree.
+        // Deltas carry the hash of the state they start from and the one they lead to
+        template <typename... Components>
+        uint64_t StateHash() const
+        {
+            mys::HashWriter hash;
+            WriteSnapshotHeader<Components...>(hash, SnapshotHeader::SnapshotMagic);
+
+            const EntityTable& table = ReadTable();
+            detail::WriteValue(hash, static_cast<uint64_t>(table.entities.size()));
+            detail::WritePaged(hash, table.entities);
+            detail::WritePaged(hash, table.destroyTimes);
+            detail::WritePaged(hash, table.pendingDestroy);
+            SaveEntityQueues(hash);
+
+            (detail::WriteValue(hash, HashContainer<Components>()), ...);
+            return hash.Hash();
+        }
+
+        // Writes what changed from aBaseline to this registry: entity slots as XOR runs, created and destroyed
+        // entities, added and removed components and the changed bytes of the rest. Applying it with ApplyDelta to a
+        // registry in the state of aBaseline brings it to the state of this one, so a rollback or replication baseline
+        // can be kept as a registry restored from a snapshot
+        template <typename... Components, typename Writer>
+        void Delta(const Registry& aBaseline, Writer& aWriter) const
+        {
+            WriteSnapshotHeader<Components...>(aWriter, SnapshotHeader::DeltaMagic);
+            detail::WriteValue(aWriter, aBaseline.StateHash<Components...>());
+            detail::WriteValue(aWriter, StateHash<Components...>());
+
+            const EntityTable& baseline = aBaseline.ReadTable();
+            const EntityTable& table = ReadTable();
+            const uint64_t baselineCount = baseline.entities.size();
+            const uint64_t count = table.entities.size();
+            detail::WriteValue(aWriter, baselineCount);
+            detail::WriteValue(aWriter, count);
+            detail::WritePagedDelta(aWriter, baseline.entities, table.entities);
+            detail::WritePagedDelta(aWriter, baseline.destroyTimes, table.destroyTimes);
+
+            // Slots whose pending flag flipped, new slots start out not pending
+            auto flipped = detail::MakeRunWriter<Entity>([&aWriter](const Entity* someSlots, Entity aCount)
+            {
+                detail::WriteValue(aWriter, aCount);
+                aWriter.Write(someSlots, aCount * sizeof(Entity));
+            });
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (table.pendingDestroy[i] != (i < baselineCount ? baseline.pendingDestroy[i] : 0))
+                    flipped.Push(static_cast<Entity>(i));
+            }
+            flipped.Finish();
+            SaveEntityQueues(aWriter);
+
+            (SaveContainerDelta<Components>(aBaseline, aWriter), ...);
+        }
+
+        // Applies a delta written by Delta<Components...>. Returns false and leaves the registry untouched if the delta
+        // was written for other types or starts from another state, which also rejects applying the same delta twice.
+        // A delta that turns out to be cut off part way, or to hold runs, slots or entities that don't fit the registry,
+        // is rejected as well but leaves the registry partly updated. Its remembered state is dropped then, so it has
+        // to be restored from a snapshot before further deltas apply. Component bytes aren't checked, deltas from
+        // sources that may corrupt them need a checksum of their own.
+        // The registry remembers the state Restore or ApplyDelta left it in, so the work done follows the size of the
+        // delta. Creating or removing entities or components in between makes it hash itself again, and so do writes
+        // to components of the listed types, which are found through their change versions. To tell those apart from
+        // the writes of Restore and ApplyDelta themselves, both close the current version with AdvanceVersion
+        template <typename... Components, typename Reader>
+        bool ApplyDelta(Reader& aReader)
+        {
+            if (!ReadSnapshotHeader<Components...>(aReader, SnapshotHeader::DeltaMagic))
+                return false;
+            const uint64_t baselineHash = detail::ReadValue<uint64_t>(aReader);
+            const uint64_t targetHash = detail::ReadValue<uint64_t>(aReader);
+            const bool remembered = myStateHash && !(WrittenSince<Components>(myStateVersion) || ...);
+            if (baselineHash != (remembered ? myStateHash : StateHash<Components...>()))
+                return false;
+            const uint64_t baselineCount = detail::ReadValue<uint64_t>(aReader);
+            const uint64_t count = detail::ReadValue<uint64_t>(aReader);
+            if (baselineCount != ReadTable().entities.size() || count > EntityTraits::IndexMask || detail::ReadFailed(aReader))
+                return false;
+
+            // Pages a fork still shares are only copied if the delta changes them
+            EntityTable& table = WriteTable();
+            table.entities.resize(count);
+            table.destroyTimes.resize(count);
+            table.pendingDestroy.resize(count);
+            if (!detail::ReadPagedDelta(aReader, table.entities, baselineCount) || !detail::ReadPagedDelta(aReader, table.destroyTimes, baselineCount))
+                return false;
+            for (Entity run = detail::ReadRunLength(aReader); run; run = detail::ReadRunLength(aReader))
             {
-                bool excluded = std::apply([aEntity](auto* ...container) -> bool
+                if (run > detail::RunLength)
+                    return false;
+                for (Entity i = 0; i < run; ++i)
                 {
-                    size_t contains = 0;
-
-                    contains = (container->Contains(aEntity) + ...);
+                    const Entity slot = detail::ReadValue<Entity>(aReader);
+                    if (slot >= count)
+                        return false;
+                    table.pendingDestroy[slot] ^= 1;
+                }
+            }
+            if (!LoadEntityQueues(aReader, count))
+                return false;
 
-                    return contains == 0;
-                }, excludes);
+            // Removed slots still hold signature bits until their components are gone
+            table.signatures.resize((std::max)(count, baselineCount));
+            if (!(GetContainer<Components>()->ApplyDelta(aReader, std::as_const(table).entities) && ...))
+                return false;
+            table.signatures.resize(count);
+            RememberState(targetHash);
+            return true;
+        }
 
-                return types && excluded;
+        Entity Create()
+        {
+            EntityTable& table = WriteTable();
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            if (myEntityQueue.Size())
+            {
+                const Entity index = myEntityQueue.Dequeue();
+                return table.entities[index] = EntityTraits::Combine(index, EntityTraits::Version(table.entities[index]));
             }
-            else
-                return types;
+#else
+            if (myFreeList != EntityTraits::IndexMask)
+            {
+                const Entity index = myFreeList;
+                myFreeList = EntityTraits::Index(table.entities[index]);
+                return table.entities[index] = EntityTraits::Combine(index, EntityTraits::Version(table.entities[index]));
+            }
+#endif
+
+            ECS_ASSERT(table.entities.size() < EntityTraits::IndexMask && "Out of entity indices");
+            const Entity entity = EntityTraits::Combine(static_cast<Entity>(table.entities.size()), 0);
+            table.entities.push_back(entity);
+            table.pendingDestroy.push_back(false);
+            table.destroyTimes.push_back(0.0);
+            table.signatures.emplace_back();
+            return entity;
         }
-    private:
-        std::tuple<Container<Types>*...> arr;
-        std::tuple<Container<Excludes>*...> excludes;
-        Entity* it;
-        Entity* end;
-    };
 
-    template <typename, typename>
-    class TypeViewEachIterator;
+        // Fills the range with new entities, recycled ones first
+        template <typename It>
+        void Create(It aFirst, It aLast)
+        {
+            const size_t count = static_cast<size_t>(std::distance(aFirst, aLast));
+            EntityTable& table = WriteTable();
+            table.entities.reserve(table.entities.size() + count);
+            table.pendingDestroy.reserve(table.pendingDestroy.size() + count);
+            table.destroyTimes.reserve(table.destroyTimes.size() + count);
+            table.signatures.reserve(table.signatures.size() + count);
 
-    template <typename... Types, typename... Excludes>
-    class TypeViewEachIterator<TList<Types...>, TList<Excludes...>>
-    {
-    private:
-        using IteratorType = TypeViewIterator<TList<Types...>, TList<Excludes...>>;
-    public:
-        TypeViewEachIterator(IteratorType&& aIterator) : it(aIterator)
-        {}
+            for (; aFirst != aLast; ++aFirst)
+                *aFirst = Create();
+        }
+
+        void Destroy(Entity aEntity)
+        {
+            ECS_ASSERT_VALID_ENTITY(Alive(aEntity) && "Destroying invalid entity");
+            ECS_ASSERT(aEntity != nullentity);
+
+            // Only the containers the entity has a component in are visited. The signature is copied since
+            // every container clears its bit on the way
+            EntityTable& table = WriteTable();
+            const Entity index = EntityTraits::Index(aEntity);
+            const Signature signature = table.signatures[index];
+            // Destroy listeners may emplace types the registry hasn't seen yet, which grows the lists, so they are
+            // walked by index
+            signature.Each([this, aEntity](Entity aBit) { mySignedContainers[aBit]->Destroy(aEntity); });
+            for (size_t i = 0; i < myUnsignedContainers.size(); ++i)
+                myUnsignedContainers[i]->Destroy(aEntity);
+
+            // Free slots keep the version the next handle will get. Their index part links to the next free slot
+            // instead of pointing back at themselves, which is how free slots are told apart from live ones
+            table.pendingDestroy[index] = false;
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            table.entities[index] = EntityTraits::Combine(EntityTraits::IndexMask, EntityTraits::NextVersion(aEntity));
+            myEntityQueue.Enqueue(index);
+#else
+            table.entities[index] = EntityTraits::Combine(myFreeList, EntityTraits::NextVersion(aEntity));
+            myFreeList = index;
+#endif
+        }
 
-        std::tuple<Entity, Types&...> operator*()
+        void Destroy(Entity aEntity, const float aTime)
+        {
+            ECS_ASSERT_VALID_ENTITY(Valid(aEntity));
+            ECS_ASSERT(aEntity != nullentity);
+
+            // Deadlines are absolute on the registry clock, so waiting timers cost nothing per frame
+            EntityTable& table = WriteTable();
+            const Entity index = EntityTraits::Index(aEntity);
+            table.pendingDestroy[index] = true;
+            table.destroyTimes[index] = myClock + aTime;
+            myEntityDestroyQueue.Enqueue({ table.destroyTimes[index], aEntity });
+        }
+
+        void LateDestroy(Entity aEntity)
         {
-            return std::apply(
-                [entity = *it](auto* ...container) 
-                {
-                    return std::tuple_cat(std::tuple<Entity>(entity), std::forward_as_tuple(container->Get(entity))...);
-                },
-                it.Tuple()
-            );
+            ECS_ASSERT_VALID_ENTITY(Valid(aEntity));
+            ECS_ASSERT(aEntity != nullentity && "Cant't destroy null entity");
+            EntityTable& table = WriteTable();
+            table.pendingDestroy[EntityTraits::Index(aEntity)] = true;
+            table.destroyTimes[EntityTraits::Index(aEntity)] = -1.0;
+            myEntityDestroyList.push_back(aEntity);
         }
 
-        bool operator!=(const TypeViewEachIterator& aRhs)
+        // Cancels a LateDestroy or timed Destroy, the entity becomes valid again
+        void CancelDestroy(Entity aEntity)
         {
-            return it != aRhs.it;
+            ECS_ASSERT_VALID_ENTITY(Alive(aEntity) && "Cancelling destroy of invalid entity");
+            WriteTable().pendingDestroy[EntityTraits::Index(aEntity)] = false;
         }
 
-        bool operator==(const TypeViewEachIterator& aRhs)
+        // Accumulated time deltas of every Update, timed destroys are scheduled against it
+        double Clock() const
         {
-            return it == aRhs.it;
+            return myClock;
         }
 
-        inline TypeViewEachIterator& operator++()
+        // True if the entity is alive and not scheduled for destruction
+        bool Valid(Entity aEntity) const
         {
-            while (++it != it && it.Valid(*it));
-            return *this;
+            return Alive(aEntity) && !ReadTable().pendingDestroy[EntityTraits::Index(aEntity)];
         }
 
-        inline TypeViewEachIterator& operator++(int)
+        // True if the handle refers to the current occupant of its slot, stale handles have an older version
+        bool Alive(Entity aEntity) const
         {
-            TypeViewEachIterator tmp = *this;
-            ++(*this);
-            return tmp;
+            const mys::PagedVector<Entity>& entities = ReadTable().entities;
+            const Entity index = EntityTraits::Index(aEntity);
+            return index < entities.size() && entities[index] == aEntity;
         }
 
-    private:
-        IteratorType it;
-    };
-
-    template <typename T1, typename T2>
-    class TypeView;
-
-    template <typename... Types, typename... Excludes>
-    class TypeView<TList<Types...>, TList<Excludes...>>
-    {
-    public:
-        using Iterator = TypeViewIterator<TList<Types...>, TList<Excludes...>>;
-        using EachIterator = TypeViewEachIterator<TList<Types...>, TList<Excludes...>>;
-        using EachIteratorWrapper = IIterator<TypeViewEachIterator<TList<Types...>, TList<Excludes...>>>;
-    public:
-
-        TypeView(const std::tuple<Container<Types>*...>& someTypes, const std::tuple<Container<Excludes>*...>& someExcludes) :
-            excludes(someExcludes),
-            types(someTypes),
-            smallest{
-                std::apply([](auto* ...container) -> IContainer*
-                {
-                    return (std::min)({((IContainer*)container)...},
-                    [](auto* lhs, auto* rhs)
-                    {
-                        return lhs->Size() < rhs->Size();
-                    }
-                );
-            }, someTypes) }
-        {}
-        
-            
-
-        Iterator begin()
+        // Adding and removing components sets signature bits in the entity table, so those paths take WriteTable first
+        template <typename T, typename... Args>
+        ComponentRef<T> Emplace(Entity aEntity, Args&&... args)
         {
-            return Iterator(&smallest->DenseFront(), types, excludes, (&smallest->DenseBack()) + 1);
+            WriteTable();
+            return GetContainer<T>()->Emplace(aEntity, std::forward<Args>(args)...);
         }
 
-        Iterator end()
+        template <typename T, typename... Args>
+        ComponentRef<T> EmplaceOrReplace(Entity aEntity, Args&&... args)
         {
-            return Iterator((&smallest->DenseBack()) + 1, types, excludes, (&smallest->DenseBack()) + 1);
+            WriteTable();
+            Container<T>* c = GetContainer<T>();
+            if (c->Contains(aEntity))
+                return Replace<T>(aEntity, std::forward<Args>(args)...);
+            return c->Emplace(aEntity, std::forward<Args>(args)...);
         }
 
-        EachIteratorWrapper Each()
+        template <typename T, typename... Args>
+        ComponentRef<T> Replace(Entity aEntity, Args&&... args)
         {
-            return EachIteratorWrapper(EachIterator(begin()), EachIterator(end()));
+            if constexpr (std::is_aggregate_v<T>)
+                return Patch<T>(aEntity, [&args...](auto&& aComponent) { aComponent = T{ std::forward<Args>(args)... }; });
+            else
+                return Patch<T>(aEntity, [&args...](auto&& aComponent) { aComponent = T(std::forward<Args>(args)...); });
         }
 
-    private:
-
-        IContainer* smallest;
-        std::tuple<Container<Types>*...> types;
-        std::tuple<Container<Excludes>*...> excludes;
-    };
-
-    class Registry
-    {
-    public:
-        friend class EntityIterator;
-
-        ~Registry()
+        // Edits the component in place through aFunction(T&), or aFunction(ComponentRef<T>&) for SoA components, then
+        // emits OnUpdate. Writes through Get or views are not tracked
+        template <typename T, typename Func>
+        ComponentRef<T> Patch(Entity aEntity, Func&& aFunction)
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                delete myContainers[i];
+            ComponentRef<T> component = Get<T>(aEntity);
+            aFunction(component);
+            GetContainer<T>()->Updated(aEntity);
+            return component;
         }
 
-        void Clear()
+        // Signals of one component type. OnConstruct listeners run after an entity got a T, OnDestroy listeners before
+        // it loses one, also when the entity is destroyed, and OnUpdate listeners after Patch, Replace or ApplyDelta
+        // changed it. Listeners must not add or remove T themselves. They stay connected through Clear and Restore,
+        // which don't emit for the components they drop or load, and forks start without any
+        template <typename T>
+        void OnConstruct(Listener aListener)
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                delete myContainers[i];
+            GetSignals<T>()->construct.push_back(aListener);
+        }
 
-            myNext = 0;
-            myEntityQueue.Clear();
-            myEntityDestroyList.clear();
-            myEntityDestroyListAfterTime.clear();
-            myContainers.Clear();
+        template <typename T>
+        void OnDestroy(Listener aListener)
+        {
+            GetSignals<T>()->destroy.push_back(aListener);
         }
 
-        Entity Create()
+        template <typename T>
+        void OnUpdate(Listener aListener)
         {
-            return (myEntityQueue.Size()) ? myEntityQueue.Dequeue() : myNext++;
+            GetSignals<T>()->update.push_back(aListener);
         }
 
-        void Destroy(Entity aEntity)
+        // Runs aListener with nullentity once the registry is destroyed, so objects that listen to its signals can
+        // tell it is gone instead of disconnecting from a dead registry. Kept through Clear and Restore
+        void OnRelease(Listener aListener)
         {
-            ECS_ASSERT_VALID_ENTITY(!myEntityQueue.Contains(aEntity) && "Destroying invalid entity");
-            ECS_ASSERT(aEntity != nullentity);
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                myContainers[i]->Destroy(aEntity);
+            myOnRelease.push_back(aListener);
+        }
 
-            //ECS_ASSERT(!myEntityQueue.Contains(aEntity));
-            myEntityQueue.Enqueue(aEntity);
-            //ECS_ASSERT(myEntityQueue.Contains(aEntity));
+        void DisconnectRelease(Listener aListener)
+        {
+            myOnRelease.erase(std::remove(myOnRelease.begin(), myOnRelease.end(), aListener), myOnRelease.end());
         }
 
-        void Destroy(Entity aEntity, const float aTime)
+        // Removes aListener from every signal of T
+        template <typename T>
+        void Disconnect(Listener aListener)
         {
-            ECS_ASSERT_VALID_ENTITY(Valid(aEntity));
-            ECS_ASSERT(aEntity != nullentity);
-            myEntityDestroyListAfterTime.push_back({ aTime, aEntity });
+            const Entity id = TypeID::Type<T>();
+            if (!mySignals.Size() || !mySignals.Contains(id))
+                return;
+            detail::Signals* signals = mySignals.Get(id);
+            for (std::pmr::vector<Listener>* signal : { &signals->construct, &signals->destroy, &signals->update })
+                signal->erase(std::remove(signal->begin(), signal->end(), aListener), signal->end());
         }
 
-        void LateDestroy(Entity aEntity)
+        // Gives every entity in the range the same component, or one component each when given a component iterator
+        template <typename T, typename EntityIt>
+        void Insert(EntityIt aFirst, EntityIt aLast, const T& aValue = {})
         {
-            ECS_ASSERT_VALID_ENTITY(Valid(aEntity));
-            ECS_ASSERT(aEntity != nullentity && "Cant't destroy null entity");
-            myEntityDestroyList.push_back(aEntity);
+            WriteTable();
+            GetContainer<T>()->Insert(aFirst, aLast, aValue);
         }
 
-        bool Valid(Entity aEntity)
+        template <typename T, typename EntityIt, typename ComponentIt, typename = typename std::iterator_traits<ComponentIt>::iterator_category>
+        void Insert(EntityIt aFirst, EntityIt aLast, ComponentIt aFrom)
         {
-            return aEntity < myNext && aEntity != ecs::nullentity
-                && !myEntityQueue.Contains(aEntity)
-                && (std::find(myEntityDestroyList.begin(), myEntityDestroyList.end(), aEntity) == myEntityDestroyList.end())
-                && (std::find_if(myEntityDestroyListAfterTime.begin(), myEntityDestroyListAfterTime.end(), [entity = aEntity](std::pair<float, Entity>& aPair) {return aPair.second == entity; }) == myEntityDestroyListAfterTime.end());
+            WriteTable();
+            GetContainer<T>()->Insert(aFirst, aLast, aFrom);
         }
 
-        template <typename T, typename... Args>
-        T& Emplace(Entity aEntity, Args&&... args)
+        template <typename T>
+        void Reserve(size_t aCapacity)
         {
-            return GetContainer<T>()->Emplace(aEntity, args...);
+            GetContainer<T>()->Reserve(aCapacity);
         }
 
+        // Only reads, so the component's change version is left alone and a fork keeps sharing it
         template <typename T>
-        const T& Get(Entity aEntity) const
+        ConstComponentRef<T> Get(Entity aEntity) const
         {
             ECS_ASSERT(aEntity != nullentity);
 
-            const Entity id = TypeID::Type<T>();
-
-            ECS_ASSERT((myContainers.Size() && myContainers.Contains(id)) && "No such components exist");
-
-            Container<T>* c = (Container<T>*)myContainers.Get(id);
+            const Container<T>* c = FindContainer<T>();
+            ECS_ASSERT(c && "No such components exist");
             ECS_ASSERT(c->Contains(aEntity) && "Entity has no such component");
             return c->Get(aEntity);
         }
 
         template <typename T>
-        T& Get(Entity aEntity)
+        ComponentRef<T> Get(Entity aEntity)
         {
             ECS_ASSERT(aEntity != nullentity);
 
@@ -677,72 +3274,155 @@ namespace ecs
 
             Container<T>* c = (Container<T>*)myContainers.Get(id);
             ECS_ASSERT(c->Contains(aEntity) && "Entity has no such component");
+            WriteTable();
             c->Destroy(aEntity);
         }
 
         template <typename T>
-        bool Contains(Entity aEntity)
+        bool Contains(Entity aEntity) const
         {
-            const Entity id = TypeID::Type<T>();
-            return myContainers.Contains(id) && myContainers.Get(id)->Contains(aEntity);
+            const Container<T>* c = FindContainer<T>();
+            return c && c->Contains(aEntity);
         }
 
         void Update(mys::UpdateContext& anUpdateContext)
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                myContainers[i]->Update(anUpdateContext);
+            if (myContactPhase == ContactPhase::BeforeUpdate)
+                DispatchContacts();
 
-            for (Entity i = 0; i < myEntityDestroyList.size(); ++i)
-                Destroy(myEntityDestroyList[i]);
-            myEntityDestroyList.clear();
+            // Hooks may emplace types the registry hasn't seen yet, which adds to the list, so it is walked by index
+            const std::pmr::vector<IContainer*>& hook = myHooks[UpdateHook];
+            for (size_t i = 0; i < hook.size(); ++i)
+                hook[i]->Update(anUpdateContext);
+
+            if (myContactPhase == ContactPhase::AfterUpdate)
+                DispatchContacts();
+
+            UpdateDestroyLists(anUpdateContext);
+        }
+
+        // Containers still update one after another, but components marked ParallelSafe update across the pool
+        void Update(mys::UpdateContext& anUpdateContext, mys::ThreadPool& aPool)
+        {
+            if (myContactPhase == ContactPhase::BeforeUpdate)
+                DispatchContacts();
+
+            const std::pmr::vector<IContainer*>& hook = myHooks[UpdateHook];
+            for (size_t i = 0; i < hook.size(); ++i)
+                hook[i]->Update(anUpdateContext, aPool);
+
+            if (myContactPhase == ContactPhase::AfterUpdate)
+                DispatchContacts();
+
+            UpdateDestroyLists(anUpdateContext);
+        }
+
+        enum class ContactPhase
+        {
+            Manual,
+            BeforeUpdate,
+            AfterUpdate
+        };
+
+        // Queued contacts are dispatched by DispatchContacts, or by Update in the chosen phase
+        void SetContactPhase(ContactPhase aPhase)
+        {
+            myContactPhase = aPhase;
+        }
+
+        void QueueContact(Entity aOwner, Entity aOther, ContactKind aKind)
+        {
+            myContacts.push_back({ aOwner, aOther, aKind });
+        }
+
+        void QueueContacts(const ContactEvent* someEvents, size_t aCount)
+        {
+            myContacts.insert(myContacts.end(), someEvents, someEvents + aCount);
+        }
+
+        void DispatchContacts()
+        {
+            // Callbacks may queue new contacts, those are left for the next dispatch. The queue and the batch being
+            // dispatched trade buffers, so dispatching every frame keeps reusing the same two
+            std::pmr::vector<ContactEvent> contacts(myResource);
+            contacts.swap(myDispatchedContacts);
+            contacts.swap(myContacts);
+            OnContacts(contacts.data(), contacts.size());
+            contacts.clear();
+            if (contacts.capacity() > myDispatchedContacts.capacity())
+                myDispatchedContacts.swap(contacts);
+        }
 
-            for (Entity i = 0; i < myEntityDestroyListAfterTime.size(); ++i)
+        // Dispatches a batch right away. Events are grouped by kind, and each container that implements the
+        // callback for that kind streams through its matching events in dense order
+        void OnContacts(const ContactEvent* someEvents, size_t aCount)
+        {
+            // Callbacks dispatching contacts themselves find the bucket taken and start an empty one
+            std::pmr::vector<ContactEvent> bucket(myResource);
+            bucket.swap(myContactBucket);
+            bucket.reserve(aCount);
+            for (size_t kind = 0; kind < static_cast<size_t>(ContactKind::Count); ++kind)
             {
-                std::pair<float, Entity>& e = myEntityDestroyListAfterTime[i];
-                e.first -= anUpdateContext.timeDelta;
-                if (e.first <= 0)
-                {
-                    Destroy(e.second);
-                    std::swap(e, myEntityDestroyListAfterTime.back());
-                    myEntityDestroyListAfterTime.pop_back();
-                    --i;
+                const std::pmr::vector<IContainer*>& hook = myHooks[CollisionEnterHook + kind];
+                if (hook.empty())
                     continue;
+
+                bucket.clear();
+                for (size_t i = 0; i < aCount; ++i)
+                {
+                    if (static_cast<size_t>(someEvents[i].kind) == kind)
+                        bucket.push_back(someEvents[i]);
                 }
+
+                if (bucket.empty())
+                    continue;
+
+                for (size_t i = 0; i < hook.size(); ++i)
+                    hook[i]->OnContacts(static_cast<ContactKind>(kind), bucket.data(), bucket.size());
             }
+
+            bucket.clear();
+            if (bucket.capacity() > myContactBucket.capacity())
+                myContactBucket.swap(bucket);
         }
 
         void OnCollisionEnter(Entity aOwner, Entity aEntering)
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                if (myContainers[i]->Contains(aOwner))
-                    myContainers[i]->OnCollisionEnter(aOwner, aEntering);
+            const std::pmr::vector<IContainer*>& hook = myHooks[CollisionEnterHook];
+            for (size_t i = 0; i < hook.size(); ++i)
+                if (hook[i]->Contains(aOwner))
+                    hook[i]->OnCollisionEnter(aOwner, aEntering);
         }
 
         void OnCollisionExit(Entity aOwner, Entity aExiting)
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                if (myContainers[i]->Contains(aOwner))
-                    myContainers[i]->OnCollisionExit(aOwner, aExiting);
+            const std::pmr::vector<IContainer*>& hook = myHooks[CollisionExitHook];
+            for (size_t i = 0; i < hook.size(); ++i)
+                if (hook[i]->Contains(aOwner))
+                    hook[i]->OnCollisionExit(aOwner, aExiting);
         }
 
         void OnTriggerEnter(Entity aOwner, Entity aEntering)
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                if (myContainers[i]->Contains(aOwner))
-                    myContainers[i]->OnTriggerEnter(aOwner, aEntering);
+            const std::pmr::vector<IContainer*>& hook = myHooks[TriggerEnterHook];
+            for (size_t i = 0; i < hook.size(); ++i)
+                if (hook[i]->Contains(aOwner))
+                    hook[i]->OnTriggerEnter(aOwner, aEntering);
         }
 
         void OnTriggerExit(Entity aOwner, Entity aExiting)
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                if (myContainers[i]->Contains(aOwner))
-                    myContainers[i]->OnTriggerExit(aOwner, aExiting);
+            const std::pmr::vector<IContainer*>& hook = myHooks[TriggerExitHook];
+            for (size_t i = 0; i < hook.size(); ++i)
+                if (hook[i]->Contains(aOwner))
+                    hook[i]->OnTriggerExit(aOwner, aExiting);
         }
 
         void Start()
         {
-            for (Entity i = 0; i < myContainers.Size(); ++i)
-                myContainers[i]->Start();
+            const std::pmr::vector<IContainer*>& hook = myHooks[StartHook];
+            for (size_t i = 0; i < hook.size(); ++i)
+                hook[i]->Start();
         }
 
         template <typename T, typename Func>
@@ -751,6 +3431,13 @@ namespace ecs
             GetContainer<T>()->Sort(aComparator);
         }
 
+        // Orders T after the dense order of U, so View<U, T> walks both containers front to back
+        template <typename T, typename U>
+        void SortAs()
+        {
+            GetContainer<T>()->SortAs(*GetContainer<U>());
+        }
+
         template <typename T>
         Reference<T> CreateReference(Entity aEntity)
         {
@@ -783,28 +3470,283 @@ namespace ecs
             Inspect<Types...>(aEntity, aFunctor);
         }
 
+        // A view of const T only reads T, which leaves its change versions alone and doesn't copy it in a fork.
+        // Systems scheduled with Read<T> have to go through one, or through Get on a const registry
         template <typename T1, typename... Types>
         TypeView<TList<T1, Types...>, TList<>> View()
         {
-            auto c = GetContainer<T1>();
-            return { std::make_tuple(c, GetContainer<Types>()...), std::make_tuple() };
+            auto c = GetContainer<std::remove_const_t<T1>>();
+            return { std::make_tuple(c, GetContainer<std::remove_const_t<Types>>()...), std::make_tuple() };
         }
 
         template <typename T1, typename... Types, typename... Excludes>
         TypeView<TList<T1, Types...>, TList<Excludes...>> View(ecs::Exclude<Excludes...>)
         {
-            auto c = GetContainer<T1>();
-            return { std::make_tuple(c, GetContainer<Types>()...), std::make_tuple(GetContainer<Excludes>()...) };
+            auto c = GetContainer<std::remove_const_t<T1>>();
+            return { std::make_tuple(c, GetContainer<std::remove_const_t<Types>>()...), std::make_tuple(GetContainer<std::remove_const_t<Excludes>>()...) };
+        }
+
+        // Owning groups take over the order of the owned containers, a component can only be owned by one group
+        template <typename... Owned>
+        TypeGroup<TList<Owned...>, TList<>, TList<>> Group()
+        {
+            return GetGroup<Owned...>(TList<>{}, TList<>{});
+        }
+
+        template <typename... Owned, typename... Gets>
+        TypeGroup<TList<Owned...>, TList<Gets...>, TList<>> Group(ecs::Get<Gets...>)
+        {
+            return GetGroup<Owned...>(TList<Gets...>{}, TList<>{});
+        }
+
+        template <typename... Owned, typename... Excludes>
+        TypeGroup<TList<Owned...>, TList<>, TList<Excludes...>> Group(ecs::Exclude<Excludes...>)
+        {
+            return GetGroup<Owned...>(TList<>{}, TList<Excludes...>{});
+        }
+
+        template <typename... Owned, typename... Gets, typename... Excludes>
+        TypeGroup<TList<Owned...>, TList<Gets...>, TList<Excludes...>> Group(ecs::Get<Gets...>, ecs::Exclude<Excludes...>)
+        {
+            return GetGroup<Owned...>(TList<Gets...>{}, TList<Excludes...>{});
         }
 
         inline EntityIteratorWrapper Entities()
         {
-            EntityIterator a(*this, 0, myNext);
-            EntityIterator b(*this, myNext, myNext);
+            const Entity end = static_cast<Entity>(ReadTable().entities.size());
+            EntityIterator a(*this, 0, end);
+            EntityIterator b(*this, end, end);
 
             return { a,b };
         }
     private:
+        // Written ahead of every snapshot, restoring only goes ahead if it matches exactly
+        struct SnapshotHeader
+        {
+            static constexpr uint32_t SnapshotMagic = 0x53534345; // "ECSS"
+            static constexpr uint32_t DeltaMagic = 0x44534345; // "ECSD"
+
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entityBits;
+            uint32_t indexBits;
+            uint32_t recycleLowest;
+            uint32_t componentCount;
+
+            bool operator==(const SnapshotHeader& aRhs) const
+            {
+                return magic == aRhs.magic && version == aRhs.version && entityBits == aRhs.entityBits && indexBits == aRhs.indexBits &&
+                    recycleLowest == aRhs.recycleLowest && componentCount == aRhs.componentCount;
+            }
+        };
+
+        template <typename... Components>
+        static SnapshotHeader MakeSnapshotHeader(uint32_t aMagic)
+        {
+            SnapshotHeader header{};
+            header.magic = aMagic;
+            header.version = 4;
+            header.entityBits = sizeof(Entity) * 8;
+            header.indexBits = EntityTraits::IndexBits;
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            header.recycleLowest = 1;
+#endif
+            header.componentCount = sizeof...(Components);
+            return header;
+        }
+
+        // Follows the header, the size of every component that is copied bytewise and 0 for the ones written by their own Serializer
+        template <typename... Components>
+        static std::array<uint32_t, sizeof...(Components)> SnapshotComponentSizes()
+        {
+            return { (Serializer<Components>::Bulk ? static_cast<uint32_t>(sizeof(Components)) : 0u)... };
+        }
+
+        template <typename... Components, typename Writer>
+        static void WriteSnapshotHeader(Writer& aWriter, uint32_t aMagic)
+        {
+            detail::WriteValue(aWriter, MakeSnapshotHeader<Components...>(aMagic));
+            detail::WriteValue(aWriter, SnapshotComponentSizes<Components...>());
+        }
+
+        template <typename... Components, typename Reader>
+        static bool ReadSnapshotHeader(Reader& aReader, uint32_t aMagic)
+        {
+            const SnapshotHeader header = detail::ReadValue<SnapshotHeader>(aReader);
+            if (!(header == MakeSnapshotHeader<Components...>(aMagic)))
+                return false;
+            const auto sizes = detail::ReadValue<decltype(SnapshotComponentSizes<Components...>())>(aReader);
+            return sizes == SnapshotComponentSizes<Components...>();
+        }
+
+        // The free list, the late and timed destroys and the clock, written whole by snapshots and deltas alike
+        template <typename Writer>
+        void SaveEntityQueues(Writer& aWriter) const
+        {
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            const Entity freeCount = static_cast<Entity>(myEntityQueue.Size());
+            detail::WriteValue(aWriter, freeCount);
+            aWriter.Write(myEntityQueue.Data(), freeCount * sizeof(Entity));
+#else
+            detail::WriteValue(aWriter, myFreeList);
+#endif
+
+            const Entity lateCount = static_cast<Entity>(myEntityDestroyList.size());
+            detail::WriteValue(aWriter, lateCount);
+            aWriter.Write(myEntityDestroyList.data(), lateCount * sizeof(Entity));
+
+            const Entity timerCount = static_cast<Entity>(myEntityDestroyQueue.Size());
+            detail::WriteValue(aWriter, timerCount);
+            for (Entity i = 0; i < timerCount; ++i)
+            {
+                detail::WriteValue(aWriter, myEntityDestroyQueue.Data()[i].first);
+                detail::WriteValue(aWriter, myEntityDestroyQueue.Data()[i].second);
+            }
+            detail::WriteValue(aWriter, myClock);
+        }
+
+        // False if the queues don't fit a table of aCount entities or the reader ran out
+        template <typename Reader>
+        bool LoadEntityQueues(Reader& aReader, size_t aCount)
+        {
+            auto fits = [aCount](Entity aEntity)
+            {
+                return EntityTraits::Index(aEntity) < aCount;
+            };
+
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
+            myEntityQueue.Clear();
+            const Entity freeCount = detail::ReadValue<Entity>(aReader);
+            if (freeCount > aCount)
+                return false;
+            for (Entity i = 0; i < freeCount; ++i)
+            {
+                const Entity index = detail::ReadValue<Entity>(aReader);
+                if (!fits(index))
+                    return false;
+                myEntityQueue.Enqueue(index);
+            }
+#else
+            myFreeList = detail::ReadValue<Entity>(aReader);
+            if (myFreeList != EntityTraits::IndexMask && !fits(myFreeList))
+                return false;
+#endif
+
+            const Entity destroyCount = detail::ReadValue<Entity>(aReader);
+            if (destroyCount > aCount)
+                return false;
+            myEntityDestroyList.resize(destroyCount);
+            aReader.Read(myEntityDestroyList.data(), myEntityDestroyList.size() * sizeof(Entity));
+            if (!std::all_of(myEntityDestroyList.begin(), myEntityDestroyList.end(), fits))
+                return false;
+
+            // Timers were written in heap order, so enqueueing them never has to swap
+            myEntityDestroyQueue.Clear();
+            const Entity timerCount = detail::ReadValue<Entity>(aReader);
+            if (timerCount > aCount)
+                return false;
+            for (Entity i = 0; i < timerCount; ++i)
+            {
+                const double time = detail::ReadValue<double>(aReader);
+                const Entity entity = detail::ReadValue<Entity>(aReader);
+                if (!fits(entity))
+                    return false;
+                myEntityDestroyQueue.Enqueue({ time, entity });
+            }
+            myClock = detail::ReadValue<double>(aReader);
+            return !detail::ReadFailed(aReader);
+        }
+
+        template <typename T>
+        const Container<T>* FindContainer() const
+        {
+            const Entity id = TypeID::Type<T>();
+            if (myContainers.Size() && myContainers.Contains(id))
+                return static_cast<const Container<T>*>(myContainers.Get(id));
+            return nullptr;
+        }
+
+        // Types that were never used are written as empty containers
+        template <typename T, typename Writer>
+        void SaveContainer(Writer& aWriter) const
+        {
+            if (const Container<T>* container = FindContainer<T>())
+                container->Save(aWriter);
+            else
+                Container<T>(myResource).Save(aWriter);
+        }
+
+        template <typename T>
+        uint64_t HashContainer() const
+        {
+            const Container<T>* container = FindContainer<T>();
+            return container ? container->Hash() : 0;
+        }
+
+        template <typename T>
+        bool WrittenSince(Version aVersion) const
+        {
+            const Container<T>* container = FindContainer<T>();
+            return container && container->WrittenSince(aVersion);
+        }
+
+        // Everything written so far is stamped with the version closed here, later writes with newer ones
+        void RememberState(uint64_t aHash)
+        {
+            myStateHash = aHash;
+            myStateVersion = AdvanceVersion();
+        }
+
+        template <typename T, typename Writer>
+        void SaveContainerDelta(const Registry& aBaseline, Writer& aWriter) const
+        {
+            // Stands in for a type either registry never created. It is made once, since one made per delta would take
+            // new memory from an arena every time
+            static const Container<T> empty(std::pmr::new_delete_resource());
+            const Container<T>* container = FindContainer<T>();
+            const Container<T>* baseline = aBaseline.FindContainer<T>();
+            (container ? *container : empty).SaveDelta(baseline ? *baseline : empty, aWriter);
+        }
+
+        void UpdateDestroyLists(mys::UpdateContext& anUpdateContext)
+        {
+            // A negative destroy time marks a LateDestroy, entries that were cancelled and rescheduled as timed
+            // destroys since are left to their timer
+            for (Entity i = 0; i < myEntityDestroyList.size(); ++i)
+            {
+                const Entity entity = myEntityDestroyList[i];
+                const Entity index = EntityTraits::Index(entity);
+                const EntityTable& table = ReadTable();
+                if (Alive(entity) && table.pendingDestroy[index] && table.destroyTimes[index] < 0.0)
+                    Destroy(entity);
+            }
+            myEntityDestroyList.clear();
+
+            // Only expired timers are touched. Cancelled or rescheduled ones no longer match their slot's deadline
+            myClock += anUpdateContext.timeDelta;
+            while (myEntityDestroyQueue.Size() && myEntityDestroyQueue.GetTop().first <= myClock)
+            {
+                const std::pair<double, Entity> timer = myEntityDestroyQueue.Dequeue();
+                const Entity index = EntityTraits::Index(timer.second);
+                const EntityTable& table = ReadTable();
+                if (Alive(timer.second) && table.pendingDestroy[index] && table.destroyTimes[index] == timer.first)
+                    Destroy(timer.second);
+            }
+        }
+
+        template <typename... Owned, typename... Gets, typename... Excludes>
+        TypeGroup<TList<Owned...>, TList<Gets...>, TList<Excludes...>> GetGroup(TList<Gets...>, TList<Excludes...>)
+        {
+            using Handler = GroupHandler<TList<Owned...>, TList<Gets...>, TList<Excludes...>>;
+
+            const Entity id = TypeID::Type<Handler>();
+            if (myGroups.Contains(id))
+                return { *(Handler*)myGroups.Get(id) };
+
+            Handler* handler = New<Handler>(std::make_tuple(GetContainer<Owned>()...), std::make_tuple(GetContainer<Gets>()...), std::make_tuple(GetContainer<Excludes>()...));
+            myGroups.Emplace(id, handler);
+            return { *handler };
+        }
 
         template <typename T>
         Container<T>* GetContainer()
@@ -813,15 +3755,129 @@ namespace ecs
             if (myContainers.Size() && myContainers.Contains(id))
                 return (Container<T>*)myContainers.Get(id);
 
-            Container<T>* c = new Container<T>();
+            Container<T>* c = New<Container<T>>(myResource);
             myContainers.Emplace(id, c);
+            if (mySignals.Size() && mySignals.Contains(id))
+                c->SetSignals(mySignals.Get(id));
+
+            if (mySignedContainers.size() < Signature::Bits)
+            {
+                c->SetSignatureBit(WriteTable().signatures, static_cast<Entity>(mySignedContainers.size()));
+                mySignedContainers.push_back(c);
+            }
+            else
+                myUnsignedContainers.push_back(c);
+
+            // Only types that implement a hook are visited when it is dispatched
+            if constexpr (detail::HasUpdate<T, void(mys::UpdateContext&)>::value)
+                myHooks[UpdateHook].push_back(c);
+            if constexpr (detail::HasStart<T, void(void)>::value)
+                myHooks[StartHook].push_back(c);
+            if constexpr (detail::HasOnCollisionEnter<T, void(Entity)>::value)
+                myHooks[CollisionEnterHook].push_back(c);
+            if constexpr (detail::HasOnCollisionExit<T, void(Entity)>::value)
+                myHooks[CollisionExitHook].push_back(c);
+            if constexpr (detail::HasOnTriggerEnter<T, void(Entity)>::value)
+                myHooks[TriggerEnterHook].push_back(c);
+            if constexpr (detail::HasOnTriggerExit<T, void(Entity)>::value)
+                myHooks[TriggerExitHook].push_back(c);
             return c;
         }
 
-        Entity myNext{};
+        template <typename T>
+        detail::Signals* GetSignals()
+        {
+            const Entity id = TypeID::Type<T>();
+            if (mySignals.Size() && mySignals.Contains(id))
+                return mySignals.Get(id);
+
+            detail::Signals* signals = New<detail::Signals>(myResource);
+            mySignals.Emplace(id, signals);
+            GetContainer<T>()->SetSignals(signals);
+            return signals;
+        }
+
+        template <typename T, typename... Args>
+        T* New(Args&&... args)
+        {
+            return new (myResource->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template <typename Vector>
+        static void Release(Vector& aVector)
+        {
+            aVector.clear();
+            aVector.shrink_to_fit();
+        }
+
+        template <size_t... I>
+        static std::array<std::pmr::vector<IContainer*>, sizeof...(I)> MakeHooks(std::pmr::memory_resource* aResource, std::index_sequence<I...>)
+        {
+            return { ((void)I, std::pmr::vector<IContainer*>(aResource))... };
+        }
+
+        // Per entity arrays. Forks share their pages, a page is copied the first time a registry writes to it
+        struct EntityTable
+        {
+            explicit EntityTable(std::pmr::memory_resource* aResource) :
+                entities(aResource), pendingDestroy(aResource), destroyTimes(aResource), signatures(aResource)
+            {}
+
+            mys::PagedVector<Entity> entities;
+            mys::PagedVector<uint8_t> pendingDestroy;
+            mys::PagedVector<double> destroyTimes;
+            mys::PagedVector<Signature> signatures;
+        };
+
+        // Reading has to go through here, the non-const accessors of the table copy pages a fork still shares
+        const EntityTable& ReadTable() const
+        {
+            return myTable;
+        }
+
+        EntityTable& WriteTable()
+        {
+            myStateHash = 0;
+            return myTable;
+        }
+
+        EntityTable myTable;
+#ifdef ECS_RECYCLE_LOWEST_ENTITY
         mys::Heap<Entity, mys::Less<Entity>> myEntityQueue;
-        std::vector<Entity> myEntityDestroyList;
-        std::vector<std::pair<float, Entity>> myEntityDestroyListAfterTime;
+#else
+        Entity myFreeList = EntityTraits::IndexMask;
+#endif
+        std::pmr::vector<Entity> myEntityDestroyList;
+        mys::Heap<std::pair<double, Entity>, mys::Less<std::pair<double, Entity>>> myEntityDestroyQueue;
+        double myClock = 0.0;
+        // State the last Restore or ApplyDelta left the registry in, 0 once it was changed structurally since. Writes in
+        // place after myStateVersion make it stale as well
+        uint64_t myStateHash = 0;
+        Version myStateVersion = 0;
+        enum Hook
+        {
+            UpdateHook,
+            StartHook,
+            CollisionEnterHook,
+            CollisionExitHook,
+            TriggerEnterHook,
+            TriggerExitHook,
+            HookCount
+        };
+
         SparseSet<IContainer*> myContainers;
+        // Kept through Clear and Restore, unlike the containers
+        SparseSet<detail::Signals*> mySignals;
+        std::pmr::vector<IContainer*> mySignedContainers;
+        std::pmr::vector<IContainer*> myUnsignedContainers;
+        std::array<std::pmr::vector<IContainer*>, HookCount> myHooks;
+        std::pmr::vector<ContactEvent> myContacts;
+        // Buffers contact dispatch reuses every frame, an arena that never frees would otherwise grow with each one
+        std::pmr::vector<ContactEvent> myDispatchedContacts;
+        std::pmr::vector<ContactEvent> myContactBucket;
+        ContactPhase myContactPhase = ContactPhase::Manual;
+        SparseSet<IGroup*> myGroups;
+        std::pmr::vector<Listener> myOnRelease;
+        std::pmr::memory_resource* myResource;
     };
 }
\ No newline at end of file
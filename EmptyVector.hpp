@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+
+namespace mys
+{
+	// Vector of an empty type. Only the number of elements is stored, every element is the same object
+	template <typename T>
+	class EmptyVector
+	{
+	public:
+		static_assert(std::is_empty_v<T>, "EmptyVector only holds empty types");
+
+		explicit EmptyVector(std::pmr::memory_resource* = nullptr) : count(0)
+		{}
+
+		T& operator[](size_t)
+		{
+			return instance;
+		}
+
+		const T& operator[](size_t) const
+		{
+			return instance;
+		}
+
+		T& front()
+		{
+			return instance;
+		}
+
+		T& back()
+		{
+			return instance;
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&...)
+		{
+			++count;
+			return instance;
+		}
+
+		void push_back(const T&)
+		{
+			++count;
+		}
+
+		void pop_back()
+		{
+			--count;
+		}
+
+		void reserve(size_t)
+		{}
+
+		void resize(size_t aCount)
+		{
+			count = aCount;
+		}
+
+		void clear()
+		{
+			count = 0;
+		}
+
+		void shrink_to_fit()
+		{}
+
+	private:
+		T instance;
+		size_t count;
+	};
+}
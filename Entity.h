@@ -1,8 +1,57 @@
 #pragma once
 #include <cstdint>
 
+// Entities are an index into the registry combined with a version that is bumped every
+// time the index is recycled, so stale handles can be detected in constant time.
+//#define ECS_64BIT_ENTITY
+
+// Destroyed entities are recycled through an intrusive free list in constant time, most recently freed first.
+// Define this to always hand out the lowest free index instead, at O(log n) per create and destroy.
+//#define ECS_RECYCLE_LOWEST_ENTITY
+
+#ifndef ECS_ENTITY_INDEX_BITS
+#ifdef ECS_64BIT_ENTITY
+#define ECS_ENTITY_INDEX_BITS 32
+#else
+#define ECS_ENTITY_INDEX_BITS 20
+#endif
+#endif
+
 namespace ecs
 {
+#ifdef ECS_64BIT_ENTITY
+	using Entity = uint64_t;
+#else
 	using Entity = uint32_t;
+#endif
+
+	struct EntityTraits
+	{
+		static constexpr Entity IndexBits = ECS_ENTITY_INDEX_BITS;
+		static constexpr Entity VersionBits = sizeof(Entity) * 8 - IndexBits;
+
+		static_assert(IndexBits > 0 && VersionBits > 0, "Entity needs both index and version bits");
+
+		static constexpr Entity IndexMask = (Entity(1) << IndexBits) - 1;
+		static constexpr Entity VersionMask = (Entity(1) << VersionBits) - 1;
+
+		static constexpr Entity Index(Entity aEntity) { return aEntity & IndexMask; }
+		static constexpr Entity Version(Entity aEntity) { return aEntity >> IndexBits; }
+
+		static constexpr Entity Combine(Entity anIndex, Entity aVersion)
+		{
+			return (anIndex & IndexMask) | ((aVersion & VersionMask) << IndexBits);
+		}
+
+		// The highest version is never handed out to a live entity, it marks the null entity and placeholders
+		static constexpr Entity ReservedVersion = VersionMask;
+
+		static constexpr Entity NextVersion(Entity aEntity)
+		{
+			const Entity version = Version(aEntity) + 1;
+			return (version >= ReservedVersion) ? 0 : version;
+		}
+	};
+
 	constexpr Entity nullentity = (Entity(-1));
-}
\ No newline at end of file
+}
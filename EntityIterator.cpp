@@ -5,23 +5,21 @@ namespace ecs
 {
 	EntityIterator::EntityIterator(const Registry& aRegistry, Entity somePos, Entity aEnd) : myRegistry(aRegistry), myPos(somePos), myEnd(aEnd)
 	{
-		while (myPos < myEnd && myRegistry.myEntityQueue.Contains(myPos))
+		while (myPos < myEnd && EntityTraits::Index(myRegistry.ReadTable().entities[myPos]) != myPos)
 			++myPos;
 	}
 
 	EntityIterator& EntityIterator::operator++()
 	{
-		++myPos;
-
-		while (myRegistry.myEntityQueue.Contains(myPos))
-			++myPos;
+		// Free slots link to the next free index instead of their own
+		while (++myPos < myEnd && EntityTraits::Index(myRegistry.ReadTable().entities[myPos]) != myPos);
 
 		return *this;
 	}
 
 	Entity EntityIterator::operator*()
 	{
-		return myPos;
+		return myRegistry.ReadTable().entities[myPos];
 	}
 }
 
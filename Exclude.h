@@ -2,7 +2,7 @@
 
 namespace ecs
 {
-	template <typename T>
+	template <typename... T>
 	class Exclude
 	{};
-}
\ No newline at end of file
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace ecs
+{
+	// Non-owned components of a partial-owning group
+	template <typename... T>
+	class Get
+	{};
+}
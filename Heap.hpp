@@ -1,4 +1,9 @@
 #pragma once
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
 
 namespace mys
 {
@@ -33,15 +38,15 @@ namespace mys
 	class Heap
 	{
 	public:
-		Heap() : heap(nullptr), size(0), capacity(0)
+		explicit Heap(std::pmr::memory_resource* aResource = std::pmr::get_default_resource()) : heap(nullptr), size(0), capacity(0), resource(aResource)
 		{}
 
 		~Heap()
 		{
-			delete[] heap;
+			Clear();
 		}
 
-		Heap(Heap&& anOther) : capacity(anOther.capacity), size(anOther.size), heap(anOther.heap)
+		Heap(Heap&& anOther) : capacity(anOther.capacity), size(anOther.size), heap(anOther.heap), resource(anOther.resource)
 		{
 			anOther.heap = 0;
 			anOther.capacity = 0;
@@ -50,32 +55,36 @@ namespace mys
 
 		void Clear()
 		{
-			delete[] heap;
+			std::destroy(heap, heap + size);
+			if (heap)
+				resource->deallocate(heap, capacity * sizeof(T), alignof(T));
 			heap = nullptr;
 			size = 0;
 			capacity = 0;
 		}
 
-		Heap(const Heap& anOther) : capacity(anOther.capacity), size(anOther.size), heap(new T[anOther.capacity])
+		Heap(const Heap& anOther) : capacity(anOther.size), size(anOther.size), heap(nullptr), resource(anOther.resource)
 		{
-			std::copy(anOther.heap, anOther.heap + size, heap);
+			if (capacity)
+			{
+				heap = Allocate(capacity);
+				std::uninitialized_copy(anOther.heap, anOther.heap + size, heap);
+			}
 		}
 
 		Heap& operator=(const Heap& anOther)
 		{
-			
-			capacity = anOther.capacity;
+			if (this == &anOther)
+				return *this;
 
-			if (size < anOther.size)
+			Clear();
+			if (anOther.size)
 			{
-				delete[] heap;
-				heap = new T[capacity];	
+				capacity = anOther.size;
+				heap = Allocate(capacity);
+				std::uninitialized_copy(anOther.heap, anOther.heap + anOther.size, heap);
+				size = anOther.size;
 			}
-
-			size = anOther.size;
-
-			std::copy(anOther.heap, anOther.heap + size, heap);
-
 			return *this;
 		}
 
@@ -110,15 +119,18 @@ namespace mys
 		{
 			if (size >= capacity)
 			{
-				capacity = capacity * 2 + 1;
-				T* tmp = new T[capacity];
-				std::move(heap, heap + size, tmp);
-				delete[] heap;
+				const int newCapacity = capacity * 2 + 1;
+				T* tmp = Allocate(newCapacity);
+				std::uninitialized_move(heap, heap + size, tmp);
+				std::destroy(heap, heap + size);
+				if (heap)
+					resource->deallocate(heap, capacity * sizeof(T), alignof(T));
 				heap = tmp;
+				capacity = newCapacity;
 			}
 
 			int index = size++;
-			heap[index] = aElement;
+			new (heap + index) T(aElement);
 			while (Comparator{}(heap[index], heap[(index - 1) / 2])) // Bubbles up element to correct location
 			{
 				std::swap(heap[index], heap[(index - 1) / 2]);
@@ -132,10 +144,17 @@ namespace mys
 			return heap[0];
 		}
 
+		// The elements in heap order, enqueueing them in this order into an empty heap rebuilds it without any swaps
+		const T* Data() const
+		{
+			return heap;
+		}
+
 		T Dequeue()
 		{
 			T item = heap[0];
 			std::swap(heap[0], heap[--size]);
+			heap[size].~T();
 
 			int i = 0;
 
@@ -169,8 +188,14 @@ namespace mys
 		}
 
 	private:
+		T* Allocate(int aCapacity)
+		{
+			return static_cast<T*>(resource->allocate(aCapacity * sizeof(T), alignof(T)));
+		}
+
 		int capacity;
 		int size;
 		T* heap;
+		std::pmr::memory_resource* resource;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "MemoryResource.hpp"
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace mys
+{
+	namespace
+	{
+		constexpr size_t DefaultHugePageSize = 2 * 1024 * 1024;
+	}
+
+	HugePageResource::HugePageResource() : myPageSize(DefaultHugePageSize)
+	{
+#if defined(_WIN32)
+		if (const size_t largePage = GetLargePageMinimum())
+			myPageSize = largePage;
+#endif
+	}
+
+	void* HugePageResource::do_allocate(size_t aSize, size_t anAlignment)
+	{
+		// OS allocations are page aligned, which covers any alignment up to the page size
+		if (anAlignment > myPageSize)
+			throw std::bad_alloc();
+
+		const size_t size = RoundUp(aSize);
+#if defined(_WIN32)
+		void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (!memory)
+			memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+		if (!memory)
+			throw std::bad_alloc();
+		return memory;
+#elif defined(__linux__)
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (memory == MAP_FAILED)
+		{
+			memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (memory == MAP_FAILED)
+				throw std::bad_alloc();
+			madvise(memory, size, MADV_HUGEPAGE);
+		}
+		return memory;
+#else
+		return ::operator new(size, std::align_val_t(myPageSize));
+#endif
+	}
+
+	void HugePageResource::do_deallocate(void* aPointer, size_t aSize, size_t anAlignment)
+	{
+		(void)anAlignment;
+#if defined(_WIN32)
+		(void)aSize;
+		VirtualFree(aPointer, 0, MEM_RELEASE);
+#elif defined(__linux__)
+		munmap(aPointer, RoundUp(aSize));
+#else
+		::operator delete(aPointer, RoundUp(aSize), std::align_val_t(myPageSize));
+#endif
+	}
+
+	bool HugePageResource::do_is_equal(const std::pmr::memory_resource& anOther) const noexcept
+	{
+		return this == &anOther;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+namespace mys
+{
+	// Takes memory straight from the OS in huge pages where the OS grants them (Windows needs the lock pages privilege,
+	// Linux reserved or transparent huge pages) and falls back to regular pages otherwise. Sizes are rounded up to
+	// whole pages, so this is meant as the upstream of an arena or pool rather than for small allocations:
+	//
+	//     mys::HugePageResource pages;
+	//     std::pmr::monotonic_buffer_resource arena(64 << 20, &pages);    // or std::pmr::unsynchronized_pool_resource
+	//     ecs::Registry registry(&arena);
+	class HugePageResource : public std::pmr::memory_resource
+	{
+	public:
+		HugePageResource();
+
+		size_t PageSize() const
+		{
+			return myPageSize;
+		}
+
+	private:
+		void* do_allocate(size_t aSize, size_t anAlignment) override;
+		void do_deallocate(void* aPointer, size_t aSize, size_t anAlignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& anOther) const noexcept override;
+
+		size_t RoundUp(size_t aSize) const
+		{
+			return (aSize + myPageSize - 1) / myPageSize * myPageSize;
+		}
+
+		size_t myPageSize;
+	};
+}
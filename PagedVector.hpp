@@ -0,0 +1,333 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mys
+{
+	// Vector-like container that stores its elements in fixed-size pages. Growing only adds pages,
+	// so elements never move and pointers to them stay valid until the element itself is removed.
+	// A copy shares the pages with the original until one of them writes to a page, which then copies that page
+	// alone. Writes are anything that goes through a non-const accessor, so reading through a const reference never
+	// copies. While pages are shared, neither vector may be written to from several threads at once unless Unshare
+	// was called first. A vector that was never copied from or to skips the reference counts when written to.
+	template <typename T>
+	class PagedVector
+	{
+	public:
+		// Roughly 16 KB per page, rounded down to a power of two so indexing is a shift and a mask
+		static constexpr size_t PageSize = []()
+		{
+			size_t elements = (sizeof(T) < 16384) ? 16384 / sizeof(T) : 1;
+			size_t pageSize = 1;
+			while (pageSize * 2 <= elements)
+				pageSize *= 2;
+			return pageSize;
+		}();
+
+		// Pages start on a cache line, so a parallel loop can split them where no two workers share one. The line
+		// before each page holds its reference count
+		static constexpr size_t PageAlignment = alignof(T) > 64 ? alignof(T) : 64;
+
+		explicit PagedVector(std::pmr::memory_resource* aResource = std::pmr::get_default_resource()) : pages(aResource), byAddress(aResource), count(0), mayShare(false)
+		{}
+
+		// Shares the pages holding anOther's elements, allocates from the same resource as anOther
+		PagedVector(const PagedVector& anOther) : pages(anOther.pages.get_allocator()), byAddress(anOther.pages.get_allocator()), count(0), mayShare(false)
+		{
+			Share(anOther);
+		}
+
+		// Both vectors have to allocate from the same resource, a page goes back to it from whichever drops it last
+		PagedVector& operator=(const PagedVector& anOther)
+		{
+			if (this != &anOther)
+			{
+				Drop();
+				Share(anOther);
+			}
+			return *this;
+		}
+
+		~PagedVector()
+		{
+			Drop();
+		}
+
+		T& operator[](size_t anIndex)
+		{
+			return Writable(anIndex / PageSize)[anIndex & (PageSize - 1)];
+		}
+
+		const T& operator[](size_t anIndex) const
+		{
+			return pages[anIndex / PageSize][anIndex & (PageSize - 1)];
+		}
+
+		T& front()
+		{
+			return (*this)[0];
+		}
+
+		T& back()
+		{
+			return (*this)[count - 1];
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (count == pages.size() * PageSize)
+				AddPage();
+
+			T* element = new (&(*this)[count]) T(std::forward<Args>(args)...);
+			++count;
+			return *element;
+		}
+
+		void push_back(T&& anElement)
+		{
+			emplace_back(std::move(anElement));
+		}
+
+		void push_back(const T& anElement)
+		{
+			emplace_back(anElement);
+		}
+
+		void pop_back()
+		{
+			back().~T();
+			--count;
+		}
+
+		void reserve(size_t aCapacity)
+		{
+			while (pages.size() * PageSize < aCapacity)
+				AddPage();
+		}
+
+		void resize(size_t aCount)
+		{
+			reserve(aCount);
+			while (count < aCount)
+				emplace_back();
+			while (count > aCount)
+				pop_back();
+		}
+
+		// Pages are kept for reuse, except for shared ones which are left to the vectors still sharing them
+		void clear()
+		{
+			size_t kept = 0;
+			for (size_t page = 0; page < pages.size(); ++page)
+			{
+				T* data = pages[page];
+				const size_t constructed = Constructed(page);
+				if (References(data).load(std::memory_order_acquire) == 1)
+				{
+					std::destroy(data, data + constructed);
+					pages[kept++] = data;
+				}
+				else
+					Release(data, constructed);
+			}
+			pages.resize(kept);
+			count = 0;
+			mayShare.store(false, std::memory_order_relaxed);
+			Reindex();
+		}
+
+		// Frees the pages past the last element
+		void shrink_to_fit()
+		{
+			while (pages.size() * PageSize >= count + PageSize)
+			{
+				Release(pages.back(), 0);
+				pages.pop_back();
+			}
+			pages.shrink_to_fit();
+			Reindex();
+			byAddress.shrink_to_fit();
+		}
+
+		// Copies every page that is still shared, so the elements can be written to from several threads
+		void Unshare()
+		{
+			for (size_t page = 0; page < pages.size(); ++page)
+				Writable(page);
+			mayShare.store(false, std::memory_order_relaxed);
+		}
+
+		// Pointer to the element at anIndex and how many elements follow it contiguously
+		T* Chunk(size_t anIndex, size_t& aCount)
+		{
+			aCount = (std::min)(PageSize - (anIndex & (PageSize - 1)), count - anIndex);
+			return &(*this)[anIndex];
+		}
+
+		const T* Chunk(size_t anIndex, size_t& aCount) const
+		{
+			aCount = (std::min)(PageSize - (anIndex & (PageSize - 1)), count - anIndex);
+			return &(*this)[anIndex];
+		}
+
+		// Position of an element in the container, or size() if it is not stored here. A binary search over the
+		// pages sorted by address
+		size_t IndexOf(const T* anElement) const
+		{
+			auto next = std::upper_bound(byAddress.begin(), byAddress.end(), anElement, [](const T* anAddress, const PageEntry& anEntry)
+			{
+				return std::less<const T*>()(anAddress, anEntry.first);
+			});
+			if (next == byAddress.begin())
+				return count;
+			const auto& [first, page] = *(next - 1);
+			if (!std::less<const T*>()(anElement, first + PageSize))
+				return count;
+			return (std::min)(page * PageSize + static_cast<size_t>(anElement - first), count);
+		}
+
+	private:
+		using Counter = std::atomic<size_t>;
+		using PageEntry = std::pair<const T*, size_t>;
+		static_assert(sizeof(Counter) <= PageAlignment, "The reference count has to fit in front of the page");
+
+		static constexpr size_t BlockSize = PageAlignment + PageSize * sizeof(T);
+
+		static Counter& References(T* aPage)
+		{
+			return *std::launder(reinterpret_cast<Counter*>(reinterpret_cast<std::byte*>(aPage) - PageAlignment));
+		}
+
+		T* NewPage()
+		{
+			std::byte* block = static_cast<std::byte*>(pages.get_allocator().resource()->allocate(BlockSize, PageAlignment));
+			new (block) Counter(1);
+			return reinterpret_cast<T*>(block + PageAlignment);
+		}
+
+		void AddPage()
+		{
+			pages.push_back(NewPage());
+			Index(pages.size() - 1);
+		}
+
+		// Files pages[aPage] under its address for IndexOf
+		void Index(size_t aPage)
+		{
+			const PageEntry entry(pages[aPage], aPage);
+			byAddress.insert(std::upper_bound(byAddress.begin(), byAddress.end(), entry, ByAddress), entry);
+		}
+
+		void Unindex(size_t aPage)
+		{
+			const PageEntry entry(pages[aPage], aPage);
+			byAddress.erase(std::lower_bound(byAddress.begin(), byAddress.end(), entry, ByAddress));
+		}
+
+		// After the pages were swapped out wholesale
+		void Reindex()
+		{
+			byAddress.clear();
+			for (size_t page = 0; page < pages.size(); ++page)
+				byAddress.emplace_back(pages[page], page);
+			std::sort(byAddress.begin(), byAddress.end(), ByAddress);
+		}
+
+		static bool ByAddress(const PageEntry& aLhs, const PageEntry& aRhs)
+		{
+			return std::less<const T*>()(aLhs.first, aRhs.first);
+		}
+
+		// Drops this vector's reference to aPage, the last one destroys the aConstructed elements and frees it
+		void Release(T* aPage, size_t aConstructed)
+		{
+			if (References(aPage).fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+
+			std::destroy(aPage, aPage + aConstructed);
+			References(aPage).~Counter();
+			pages.get_allocator().resource()->deallocate(reinterpret_cast<std::byte*>(aPage) - PageAlignment, BlockSize, PageAlignment);
+		}
+
+		// Number of elements of this vector in aPage. A page is only written to once it is no longer shared, so
+		// every vector sharing a page holds the same elements in it
+		size_t Constructed(size_t aPage) const
+		{
+			const size_t first = aPage * PageSize;
+			return count > first ? (std::min)(PageSize, count - first) : 0;
+		}
+
+		// The page, copied first if it is shared. Pages of elements that can't be copied are never shared
+		T* Writable(size_t aPage)
+		{
+			T* page = pages[aPage];
+			if constexpr (std::is_copy_constructible_v<T>)
+			{
+				if (mayShare.load(std::memory_order_relaxed) && References(page).load(std::memory_order_acquire) != 1)
+				{
+					T* copy = NewPage();
+					const size_t constructed = Constructed(aPage);
+					std::uninitialized_copy(page, page + constructed, copy);
+					Release(page, constructed);
+					Unindex(aPage);
+					pages[aPage] = page = copy;
+					Index(aPage);
+				}
+			}
+			return page;
+		}
+
+		void Share(const PagedVector& anOther)
+		{
+			static_assert(std::is_copy_constructible_v<T>, "Shared pages are copied once written to");
+			const size_t used = (anOther.count + PageSize - 1) / PageSize;
+			pages.reserve(used);
+			for (size_t page = 0; page < used; ++page)
+			{
+				References(anOther.pages[page]).fetch_add(1, std::memory_order_relaxed);
+				pages.push_back(anOther.pages[page]);
+			}
+			byAddress.assign(anOther.byAddress.begin(), anOther.byAddress.end());
+			byAddress.erase(std::remove_if(byAddress.begin(), byAddress.end(), [used](const PageEntry& anEntry) { return anEntry.second >= used; }), byAddress.end());
+			count = anOther.count;
+			if (used > 0)
+			{
+				mayShare.store(true, std::memory_order_relaxed);
+				anOther.mayShare.store(true, std::memory_order_relaxed);
+			}
+		}
+
+		void Drop()
+		{
+			for (size_t page = 0; page < pages.size(); ++page)
+				Release(pages[page], Constructed(page));
+			pages.clear();
+			byAddress.clear();
+			count = 0;
+			mayShare.store(false, std::memory_order_relaxed);
+		}
+
+		std::pmr::vector<T*> pages;
+		// Every page with its number, ordered by address
+		std::pmr::vector<PageEntry> byAddress;
+		size_t count;
+		// Set once pages were handed to or taken from another vector, cleared once none of them can be shared.
+		// Copying from a vector marks it too, so it is mutable and atomic for copies made on several threads
+		mutable std::atomic<bool> mayShare;
+	};
+}
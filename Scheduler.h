@@ -0,0 +1,199 @@
+#pragma once
+#include "Ecs.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ecs
+{
+	template <typename... T>
+	struct Read
+	{};
+
+	template <typename... T>
+	struct Write
+	{};
+
+	// Runs systems on a thread pool based on the components they declare they read and write.
+	// Systems that share a written component run in the order they were added, everything else may overlap.
+	// Systems must not make structural changes (Create, Emplace, Remove, Destroy) unless they are added as exclusive.
+	// Components a system only reads have to be reached through const access, View<const T> or Get on a const
+	// registry, since handing out a T& stamps its change version and copies it in a forked registry.
+	class Scheduler
+	{
+	public:
+		using System = std::function<void(mys::UpdateContext&)>;
+
+		template <typename... Reads, typename... Writes, typename Func>
+		void Add(Read<Reads...>, Write<Writes...>, Func&& aSystem)
+		{
+			AddNode(std::forward<Func>(aSystem), { TypeID::Type<Reads>()... }, { TypeID::Type<Writes>()... }, false);
+		}
+
+		template <typename... Reads, typename Func>
+		void Add(Read<Reads...>, Func&& aSystem)
+		{
+			AddNode(std::forward<Func>(aSystem), { TypeID::Type<Reads>()... }, {}, false);
+		}
+
+		template <typename... Writes, typename Func>
+		void Add(Write<Writes...>, Func&& aSystem)
+		{
+			AddNode(std::forward<Func>(aSystem), {}, { TypeID::Type<Writes>()... }, false);
+		}
+
+		// Runs after every system added before it has finished and before any system added after it starts
+		template <typename Func>
+		void AddExclusive(Func&& aSystem)
+		{
+			AddNode(std::forward<Func>(aSystem), {}, {}, true);
+		}
+
+		void Clear()
+		{
+			myNodes.clear();
+			myDirty = true;
+		}
+
+		size_t Size() const
+		{
+			return myNodes.size();
+		}
+
+		// Runs every system once on the calling thread, in the order they were added
+		void Run(mys::UpdateContext& anUpdateContext)
+		{
+			for (Node& node : myNodes)
+				node.system(anUpdateContext);
+		}
+
+		void Run(mys::UpdateContext& anUpdateContext, mys::ThreadPool& aPool)
+		{
+			if (myDirty)
+				Build();
+
+			for (size_t i = 0; i < myNodes.size(); ++i)
+				myRemaining[i].store(myNodes[i].dependencies, std::memory_order_relaxed);
+
+			mys::ThreadPool::Batch batch;
+			for (size_t i = 0; i < myNodes.size(); ++i)
+			{
+				if (!myNodes[i].dependencies)
+					Launch(i, anUpdateContext, aPool, batch);
+			}
+			aPool.Wait(batch);
+		}
+
+	private:
+		struct Node
+		{
+			System system;
+			std::vector<Entity> reads;
+			std::vector<Entity> writes;
+			bool exclusive;
+
+			std::vector<size_t> dependents;
+			size_t dependencies;
+		};
+
+		static constexpr size_t npos = size_t(-1);
+
+		template <typename Func>
+		void AddNode(Func&& aSystem, std::vector<Entity> someReads, std::vector<Entity> someWrites, bool anExclusive)
+		{
+			myNodes.push_back({ System(std::forward<Func>(aSystem)), std::move(someReads), std::move(someWrites), anExclusive, {}, 0 });
+			myDirty = true;
+		}
+
+		void Launch(size_t aNode, mys::UpdateContext& anUpdateContext, mys::ThreadPool& aPool, mys::ThreadPool::Batch& aBatch)
+		{
+			aPool.Submit(aBatch, [this, aNode, &anUpdateContext, &aPool, &aBatch]()
+			{
+				myNodes[aNode].system(anUpdateContext);
+				for (size_t dependent : myNodes[aNode].dependents)
+				{
+					if (myRemaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+						Launch(dependent, anUpdateContext, aPool, aBatch);
+				}
+			});
+		}
+
+		// A system depends on the last earlier writer of everything it touches, and writers also depend on
+		// every reader since that writer. Transitive edges cover the rest.
+		void Build()
+		{
+			Entity typeCount = 0;
+			for (const Node& node : myNodes)
+			{
+				for (Entity type : node.reads)
+					typeCount = (std::max)(typeCount, type + 1);
+				for (Entity type : node.writes)
+					typeCount = (std::max)(typeCount, type + 1);
+			}
+
+			std::vector<size_t> lastWriter(typeCount, npos);
+			std::vector<std::vector<size_t>> readers(typeCount);
+			std::vector<size_t> sinceExclusive;
+			size_t lastExclusive = npos;
+
+			for (size_t i = 0; i < myNodes.size(); ++i)
+			{
+				Node& node = myNodes[i];
+				node.dependents.clear();
+
+				std::vector<size_t> dependencies;
+				if (node.exclusive)
+				{
+					dependencies = sinceExclusive;
+					if (lastExclusive != npos)
+						dependencies.push_back(lastExclusive);
+
+					std::fill(lastWriter.begin(), lastWriter.end(), npos);
+					for (std::vector<size_t>& typeReaders : readers)
+						typeReaders.clear();
+					sinceExclusive.clear();
+					lastExclusive = i;
+				}
+				else
+				{
+					if (lastExclusive != npos)
+						dependencies.push_back(lastExclusive);
+
+					for (Entity type : node.reads)
+					{
+						if (lastWriter[type] != npos)
+							dependencies.push_back(lastWriter[type]);
+						readers[type].push_back(i);
+					}
+
+					for (Entity type : node.writes)
+					{
+						if (lastWriter[type] != npos)
+							dependencies.push_back(lastWriter[type]);
+						dependencies.insert(dependencies.end(), readers[type].begin(), readers[type].end());
+						readers[type].clear();
+						lastWriter[type] = i;
+					}
+					sinceExclusive.push_back(i);
+				}
+
+				std::sort(dependencies.begin(), dependencies.end());
+				dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+				dependencies.erase(std::remove(dependencies.begin(), dependencies.end(), i), dependencies.end());
+
+				for (size_t dependency : dependencies)
+					myNodes[dependency].dependents.push_back(i);
+				node.dependencies = dependencies.size();
+			}
+
+			myRemaining.reset(new std::atomic<size_t>[myNodes.size()]);
+			myDirty = false;
+		}
+
+		std::vector<Node> myNodes;
+		std::unique_ptr<std::atomic<size_t>[]> myRemaining;
+		bool myDirty = true;
+	};
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "Entity.h"
+#include <cstdint>
+
+// Number of component types per registry that get a bit in the entity signatures, rounded up to a multiple of 64.
+// Types created after that still work, views over them just fall back to looking entities up in every container.
+#ifndef ECS_SIGNATURE_BITS
+#define ECS_SIGNATURE_BITS 64
+#endif
+
+namespace ecs
+{
+	// One bit per component type an entity has, bits are handed out by the registry in the order containers are created
+	struct Signature
+	{
+		using Word = uint64_t;
+
+		static constexpr Entity WordBits = 64;
+		static constexpr Entity Words = (ECS_SIGNATURE_BITS + WordBits - 1) / WordBits;
+		static constexpr Entity Bits = Words * WordBits;
+
+		// Bit of types that didn't get one
+		static constexpr Entity NoBit = nullentity;
+
+		void Set(Entity aBit)
+		{
+			words[aBit / WordBits] |= Word(1) << (aBit & (WordBits - 1));
+		}
+
+		void Reset(Entity aBit)
+		{
+			words[aBit / WordBits] &= ~(Word(1) << (aBit & (WordBits - 1)));
+		}
+
+		bool Test(Entity aBit) const
+		{
+			return (words[aBit / WordBits] >> (aBit & (WordBits - 1))) & 1;
+		}
+
+		// Every bit of anInclude is set and none of anExclude. Branch free, so wide signatures vectorize
+		bool Matches(const Signature& anInclude, const Signature& anExclude) const
+		{
+			Word mismatch = 0;
+			for (Entity i = 0; i < Words; ++i)
+				mismatch |= ((words[i] & anInclude.words[i]) ^ anInclude.words[i]) | (words[i] & anExclude.words[i]);
+			return mismatch == 0;
+		}
+
+		bool operator==(const Signature& aRhs) const
+		{
+			for (Entity i = 0; i < Words; ++i)
+			{
+				if (words[i] != aRhs.words[i])
+					return false;
+			}
+			return true;
+		}
+
+		// Calls aFunction(bit) for every set bit, lowest first
+		template <typename Func>
+		void Each(Func&& aFunction) const
+		{
+			for (Entity i = 0; i < Words; ++i)
+			{
+				for (Word word = words[i]; word; word &= word - 1)
+					aFunction(i * WordBits + LowestBit(word));
+			}
+		}
+
+		Word words[Words] = {};
+
+	private:
+		static Entity LowestBit(Word aWord)
+		{
+			// De Bruijn lookup of the isolated lowest bit
+			static constexpr Entity table[64] =
+			{
+				0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+				62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+				63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+				46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+			};
+			return table[((aWord & (~aWord + 1)) * 0x03f79d71b4cb0a89ull) >> 58];
+		}
+	};
+}
@@ -0,0 +1,278 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace mys
+{
+	template <typename>
+	struct MemberTraits;
+
+	template <typename Class, typename Field>
+	struct MemberTraits<Field Class::*>
+	{
+		using ClassType = Class;
+		using FieldType = Field;
+	};
+
+	// Specialize as std::true_type for types whose SoAVector leaves fields out on purpose. Those fields are not stored
+	// and read back value-initialized
+	template <typename T>
+	struct PartialSoA : std::false_type
+	{};
+
+	// Vector of T that keeps every listed field in an array of its own, so a loop over one field streams only that
+	// field and can use packed loads. Elements are accessed through Reference, which reads and writes the fields in
+	// place. Every field of T has to be listed, in declaration order, unless PartialSoA<T> says otherwise.
+	template <typename T, auto... Members>
+	class SoAVector
+	{
+	public:
+		// Every field array starts on a cache line, which also satisfies 256 and 512 bit vector loads
+		static constexpr size_t Alignment = 64;
+
+		template <auto Member>
+		using FieldType = typename MemberTraits<decltype(Member)>::FieldType;
+
+		static_assert(sizeof...(Members) > 0, "SoAVector needs at least one field");
+		static_assert((std::is_same_v<typename MemberTraits<decltype(Members)>::ClassType, T> && ...), "Fields have to be members of T");
+		static_assert((std::is_trivially_copyable_v<FieldType<Members>> && ...), "Fields have to be trivially copyable");
+		static_assert(std::is_default_constructible_v<T>, "T is gathered from its fields and has to be default constructible");
+
+		// Size of a struct holding just the listed fields in the listed order. It falls short of sizeof(T) when a field
+		// is left out, unless the field would fit in padding
+		static constexpr size_t ListedSize()
+		{
+			auto align = [](size_t aSize, size_t anAlignment) { return (aSize + anAlignment - 1) / anAlignment * anAlignment; };
+			size_t size = 0;
+			((size = align(size, alignof(FieldType<Members>)) + sizeof(FieldType<Members>)), ...);
+			return align(size, alignof(T));
+		}
+
+		static_assert(PartialSoA<T>::value || ListedSize() == sizeof(T), "List every field of T in declaration order, or specialize mys::PartialSoA<T> to leave some out");
+
+		class Reference
+		{
+		public:
+			Reference(SoAVector& aVector, size_t anIndex) : myVector(&aVector), myIndex(anIndex)
+			{}
+
+			Reference(const Reference&) = default;
+
+			// Assigning copies the fields, like assigning through a T&
+			Reference& operator=(const Reference& aRhs)
+			{
+				return *this = static_cast<T>(aRhs);
+			}
+
+			Reference& operator=(const T& aValue)
+			{
+				((Get<Members>() = aValue.*Members), ...);
+				return *this;
+			}
+
+			operator T() const
+			{
+				T value{};
+				((value.*Members = Get<Members>()), ...);
+				return value;
+			}
+
+			template <auto Member>
+			FieldType<Member>& Get() const
+			{
+				return myVector->template Data<Member>()[myIndex];
+			}
+
+		private:
+			SoAVector* myVector;
+			size_t myIndex;
+		};
+
+		explicit SoAVector(std::pmr::memory_resource* aResource = std::pmr::get_default_resource()) : count(0), capacity(0), resource(aResource)
+		{}
+
+		~SoAVector()
+		{
+			Release();
+		}
+
+		SoAVector(const SoAVector&) = delete;
+		SoAVector& operator=(const SoAVector&) = delete;
+
+		Reference operator[](size_t anIndex)
+		{
+			return Reference(*this, anIndex);
+		}
+
+		T operator[](size_t anIndex) const
+		{
+			return const_cast<SoAVector&>(*this)[anIndex];
+		}
+
+		Reference front()
+		{
+			return (*this)[0];
+		}
+
+		Reference back()
+		{
+			return (*this)[count - 1];
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		template <typename... Args>
+		Reference emplace_back(Args&&... args)
+		{
+			if constexpr (std::is_aggregate_v<T>)
+				return push_back(T{ std::forward<Args>(args)... });
+			else
+				return push_back(T(std::forward<Args>(args)...));
+		}
+
+		Reference push_back(const T& anElement)
+		{
+			if (count == capacity)
+				Grow((std::max)(capacity * 2, size_t(16)));
+
+			Reference element = (*this)[count++];
+			element = anElement;
+			return element;
+		}
+
+		void pop_back()
+		{
+			--count;
+		}
+
+		void reserve(size_t aCapacity)
+		{
+			if (aCapacity > capacity)
+				Grow(aCapacity);
+		}
+
+		// New elements are value initialized field by field
+		void resize(size_t aCount)
+		{
+			reserve(aCount);
+			if (aCount > count)
+				std::apply([this, aCount](auto* ...field) { (std::fill(field + count, field + aCount, std::remove_pointer_t<decltype(field)>{}), ...); }, fields);
+			count = aCount;
+		}
+
+		void clear()
+		{
+			count = 0;
+		}
+
+		void shrink_to_fit()
+		{
+			if (count == 0)
+			{
+				Release();
+				fields = {};
+				capacity = 0;
+			}
+			else if (count < capacity)
+				Grow(count);
+		}
+
+		void Swap(size_t aLhs, size_t aRhs)
+		{
+			(std::swap(Data<Members>()[aLhs], Data<Members>()[aRhs]), ...);
+		}
+
+		template <auto Member>
+		FieldType<Member>* Data()
+		{
+			static_assert(FieldIndex<Member>() < sizeof...(Members), "Member is not a field of this layout");
+			return std::get<FieldIndex<Member>()>(fields);
+		}
+
+		template <auto Member>
+		const FieldType<Member>* Data() const
+		{
+			static_assert(FieldIndex<Member>() < sizeof...(Members), "Member is not a field of this layout");
+			return std::get<FieldIndex<Member>()>(fields);
+		}
+
+		// Calls aFunction(fieldArray) for every field, in the order the fields were listed
+		template <typename Func>
+		void EachField(Func&& aFunction)
+		{
+			std::apply([&aFunction](auto* ...field) { (aFunction(field), ...); }, fields);
+		}
+
+		template <typename Func>
+		void EachField(Func&& aFunction) const
+		{
+			std::apply([&aFunction](const auto* ...field) { (aFunction(field), ...); }, fields);
+		}
+
+		// True if aCount elements from aFirst are bytewise equal, field by field, to the ones of anOther from anOtherFirst
+		bool Equal(const SoAVector& anOther, size_t aFirst, size_t anOtherFirst, size_t aCount) const
+		{
+			return Equal(anOther, aFirst, anOtherFirst, aCount, std::index_sequence_for<FieldType<Members>...>{});
+		}
+
+	private:
+		template <size_t... I>
+		bool Equal(const SoAVector& anOther, size_t aFirst, size_t anOtherFirst, size_t aCount, std::index_sequence<I...>) const
+		{
+			return ((std::memcmp(std::get<I>(fields) + aFirst, std::get<I>(anOther.fields) + anOtherFirst, aCount * sizeof(*std::get<I>(fields))) == 0) && ...);
+		}
+
+		template <auto>
+		struct Constant
+		{};
+
+		template <auto Member>
+		static constexpr size_t FieldIndex()
+		{
+			constexpr bool matches[] = { std::is_same_v<Constant<Member>, Constant<Members>>... };
+			for (size_t i = 0; i < sizeof...(Members); ++i)
+			{
+				if (matches[i])
+					return i;
+			}
+			return sizeof...(Members);
+		}
+
+		void Grow(size_t aCapacity)
+		{
+			std::apply([this, aCapacity](auto*& ...field) { (Reallocate(field, aCapacity), ...); }, fields);
+			capacity = aCapacity;
+		}
+
+		template <typename Field>
+		void Reallocate(Field*& aField, size_t aCapacity)
+		{
+			Field* tmp = static_cast<Field*>(resource->allocate(aCapacity * sizeof(Field), Alignment));
+			if (aField)
+			{
+				std::memcpy(tmp, aField, count * sizeof(Field));
+				resource->deallocate(aField, capacity * sizeof(Field), Alignment);
+			}
+			aField = tmp;
+		}
+
+		void Release()
+		{
+			std::apply([this](auto*& ...field) { ((field ? resource->deallocate(field, capacity * sizeof(*field), Alignment) : void()), ...); }, fields);
+		}
+
+		std::tuple<FieldType<Members>*...> fields{};
+		size_t count;
+		size_t capacity;
+		std::pmr::memory_resource* resource;
+	};
+}
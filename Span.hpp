@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+
+namespace mys
+{
+	// Non-owning view of a contiguous range
+	template <typename T>
+	struct Span
+	{
+		T* data = nullptr;
+		size_t size = 0;
+
+		T& operator[](size_t anIndex) const
+		{
+			return data[anIndex];
+		}
+
+		T* begin() const
+		{
+			return data;
+		}
+
+		T* end() const
+		{
+			return data + size;
+		}
+
+		bool empty() const
+		{
+			return size == 0;
+		}
+	};
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mys
+{
+	// Work-stealing thread pool. Every worker owns a queue and steals from the others once its own runs dry.
+	// A thread waiting on a batch runs queued tasks in the meantime, so tasks can wait on batches of their own.
+	class ThreadPool
+	{
+	public:
+		struct Batch
+		{
+			std::atomic<size_t> pending{ 0 };
+		};
+
+		explicit ThreadPool(size_t aThreadCount = std::thread::hardware_concurrency()) :
+			myThreadCount(aThreadCount ? aThreadCount : 1), myQueues(new Queue[myThreadCount])
+		{
+			myThreads.reserve(myThreadCount);
+			for (size_t i = 0; i < myThreadCount; ++i)
+				myThreads.emplace_back([this, i]() { Work(i); });
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mySleepMutex);
+				myStopping = true;
+			}
+			mySleep.notify_all();
+
+			for (std::thread& thread : myThreads)
+				thread.join();
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		size_t ThreadCount() const
+		{
+			return myThreadCount;
+		}
+
+		template <typename Func>
+		void Submit(Batch& aBatch, Func&& aFunction)
+		{
+			aBatch.pending.fetch_add(1, std::memory_order_relaxed);
+
+			// Workers push to their own queue to keep nested work local, other threads spread it out
+			const size_t index = (ourPool == this) ? ourWorkerIndex : (myNextQueue.fetch_add(1, std::memory_order_relaxed) % myThreadCount);
+			{
+				std::lock_guard<std::mutex> lock(myQueues[index].mutex);
+				myQueues[index].tasks.push_back({ std::forward<Func>(aFunction), &aBatch });
+			}
+			myQueued.fetch_add(1, std::memory_order_release);
+
+			{
+				std::lock_guard<std::mutex> lock(mySleepMutex);
+			}
+			mySleep.notify_one();
+		}
+
+		void Wait(Batch& aBatch)
+		{
+			while (aBatch.pending.load(std::memory_order_acquire) > 0)
+			{
+				Task task;
+				if (TryPop((ourPool == this) ? ourWorkerIndex : 0, task))
+					Run(task);
+				else
+					std::this_thread::yield();
+			}
+		}
+
+		// Splits [0, aCount) into chunks of at most aGrainSize and calls aFunction(begin, end) for each
+		template <typename Func>
+		void ParallelFor(size_t aCount, size_t aGrainSize, Func&& aFunction)
+		{
+			const size_t grain = (std::max)(aGrainSize, size_t(1));
+			if (aCount <= grain)
+			{
+				if (aCount)
+					aFunction(size_t(0), aCount);
+				return;
+			}
+
+			Batch batch;
+			for (size_t begin = 0; begin < aCount; begin += grain)
+			{
+				const size_t end = (std::min)(begin + grain, aCount);
+				Submit(batch, [&aFunction, begin, end]() { aFunction(begin, end); });
+			}
+			Wait(batch);
+		}
+
+	private:
+		struct Task
+		{
+			std::function<void()> function;
+			Batch* batch;
+		};
+
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		void Work(size_t anIndex)
+		{
+			ourPool = this;
+			ourWorkerIndex = anIndex;
+
+			while (true)
+			{
+				Task task;
+				if (TryPop(anIndex, task))
+				{
+					Run(task);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(mySleepMutex);
+				mySleep.wait(lock, [this]() { return myStopping || myQueued.load(std::memory_order_acquire) > 0; });
+				if (myStopping && myQueued.load(std::memory_order_acquire) == 0)
+					return;
+			}
+		}
+
+		bool TryPop(size_t anIndex, Task& aTask)
+		{
+			if (myQueued.load(std::memory_order_acquire) == 0)
+				return false;
+
+			// Own queue is used as a stack for locality, stealing takes the oldest task of a victim
+			{
+				Queue& own = myQueues[anIndex];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.tasks.empty())
+				{
+					aTask = std::move(own.tasks.back());
+					own.tasks.pop_back();
+					myQueued.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			for (size_t i = 1; i < myThreadCount; ++i)
+			{
+				Queue& victim = myQueues[(anIndex + i) % myThreadCount];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (!victim.tasks.empty())
+				{
+					aTask = std::move(victim.tasks.front());
+					victim.tasks.pop_front();
+					myQueued.fetch_sub(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void Run(Task& aTask)
+		{
+			aTask.function();
+			aTask.batch->pending.fetch_sub(1, std::memory_order_release);
+		}
+
+		inline static thread_local ThreadPool* ourPool = nullptr;
+		inline static thread_local size_t ourWorkerIndex = 0;
+
+		size_t myThreadCount;
+		std::unique_ptr<Queue[]> myQueues;
+		std::vector<std::thread> myThreads;
+
+		std::atomic<size_t> myQueued{ 0 };
+		std::atomic<size_t> myNextQueue{ 0 };
+
+		std::mutex mySleepMutex;
+		std::condition_variable mySleep;
+		bool myStopping = false;
+	};
+}
@@ -0,0 +1,138 @@
+// Times the sparse set Registry against the ArchetypeRegistry on the same workload. Build with optimizations, e.g.
+//
+//     g++ -std=c++17 -O2 -DNDEBUG ArchetypeBench.cpp ../MemoryResource.cpp -pthread -o ArchetypeBench
+//
+#include "../Archetype.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	struct Position
+	{
+		float x, y, z;
+	};
+
+	struct Velocity
+	{
+		float x, y, z;
+	};
+
+	struct Mass
+	{
+		float m;
+	};
+
+	struct Marker
+	{
+		int frame;
+	};
+
+	constexpr size_t EntityCount = 200000;
+
+	template <typename Func>
+	double Measure(Func&& aFunction, int aRepetitions = 20)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < aRepetitions; ++i)
+			aFunction();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / aRepetitions;
+	}
+
+	template <typename Registry>
+	void Run(const char* aName)
+	{
+		Registry registry;
+		std::vector<ecs::Entity> entities(EntityCount);
+		volatile float sink = 0.f;
+
+		const double create = Measure([&]
+		{
+			registry.Clear();
+			srand(1);
+			for (ecs::Entity& entity : entities)
+			{
+				entity = registry.Create();
+				registry.template Emplace<Position>(entity, Position{ 1.f, 2.f, 3.f });
+				if (rand() % 2)
+					registry.template Emplace<Velocity>(entity, Velocity{ 1.f, 1.f, 1.f });
+				if (rand() % 10 < 7)
+					registry.template Emplace<Mass>(entity, Mass{ 2.f });
+			}
+		}, 3);
+
+		const double one = Measure([&]
+		{
+			float sum = 0.f;
+			registry.template View<Position>().Each([&](ecs::Entity, Position& aPosition) { sum += aPosition.x; });
+			sink = sum;
+		});
+
+		const double three = Measure([&]
+		{
+			float sum = 0.f;
+			registry.template View<Position, Velocity, Mass>().Each([&](ecs::Entity, Position& aPosition, Velocity& aVelocity, Mass& aMass)
+			{
+				aPosition.x += aVelocity.x * aMass.m;
+				sum += aPosition.x;
+			});
+			sink = sum;
+		});
+
+		const double excluded = Measure([&]
+		{
+			float sum = 0.f;
+			registry.template View<Position, Velocity>(ecs::Exclude<Mass>()).Each([&](ecs::Entity, Position& aPosition, Velocity& aVelocity)
+			{
+				aPosition.x += aVelocity.x;
+				sum += aPosition.x;
+			});
+			sink = sum;
+		});
+
+		const double tuples = Measure([&]
+		{
+			float sum = 0.f;
+			for (auto&& [entity, position, velocity, mass] : registry.template View<Position, Velocity, Mass>().Each())
+			{
+				position.x += velocity.x * mass.m;
+				sum += position.x;
+			}
+			sink = sum;
+		});
+
+		const double get = Measure([&]
+		{
+			float sum = 0.f;
+			for (size_t i = 0; i < entities.size(); i += 7)
+				sum += registry.template Get<Position>(entities[i]).x;
+			sink = sum;
+		});
+
+		const double addRemove = Measure([&]
+		{
+			for (size_t i = 0; i < entities.size(); i += 10)
+				registry.template Emplace<Marker>(entities[i], Marker{ 1 });
+			for (size_t i = 0; i < entities.size(); i += 10)
+				registry.template Remove<Marker>(entities[i]);
+		}, 5);
+
+		printf("%s\n", aName);
+		printf("    create + emplace          %8.3f ms\n", create);
+		printf("    View<P> Each(f)           %8.3f ms\n", one);
+		printf("    View<P, V, M> Each(f)     %8.3f ms\n", three);
+		printf("    View<P, V> !Mass Each(f)  %8.3f ms\n", excluded);
+		printf("    View<P, V, M> Each()      %8.3f ms\n", tuples);
+		printf("    Get every 7th             %8.3f ms\n", get);
+		printf("    add + remove on 10%%       %8.3f ms\n", addRemove);
+	}
+}
+
+int main(void)
+{
+	Run<ecs::Registry>("Registry (sparse sets)");
+	Run<ecs::ArchetypeRegistry>("ArchetypeRegistry");
+	return 0;
+}
@@ -0,0 +1,147 @@
+// Times the ways of iterating a TypeView against a plain walk over the entities. Build with optimizations, e.g.
+//
+//     g++ -std=c++17 -O2 -DNDEBUG ViewBench.cpp ../MemoryResource.cpp -pthread -o ViewBench
+//
+#include "../Ecs.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	struct Position
+	{
+		float x, y, z;
+	};
+
+	struct Velocity
+	{
+		float x, y, z;
+	};
+
+	struct Mass
+	{
+		float m;
+	};
+
+	struct Frozen
+	{};
+
+	constexpr int EntityCount = 200000;
+	constexpr int Repetitions = 20;
+
+	template <typename Func>
+	double Measure(Func&& aFunction)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < Repetitions; ++i)
+			aFunction();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / Repetitions;
+	}
+
+	void Report(const char* aName, double aMilliseconds)
+	{
+		printf("%-36s %8.3f ms\n", aName, aMilliseconds);
+	}
+}
+
+int main(void)
+{
+	ecs::Registry registry;
+	srand(1);
+
+	for (int i = 0; i < EntityCount; ++i)
+	{
+		ecs::Entity entity = registry.Create();
+		registry.Emplace<Position>(entity, Position{ 1.f, 2.f, 3.f });
+		if (rand() % 2)
+			registry.Emplace<Velocity>(entity, Velocity{ 1.f, 1.f, 1.f });
+		if (rand() % 10 < 7)
+			registry.Emplace<Mass>(entity, Mass{ 2.f });
+		if (rand() % 5 == 0)
+			registry.Emplace<Frozen>(entity);
+	}
+
+	volatile float sink = 0.f;
+
+	Report("View<Position> entities + Get", Measure([&]
+	{
+		float sum = 0.f;
+		for (ecs::Entity entity : registry.View<Position>())
+			sum += registry.Get<Position>(entity).x;
+		sink = sum;
+	}));
+
+	Report("View<Position> Each()", Measure([&]
+	{
+		float sum = 0.f;
+		for (auto&& [entity, position] : registry.View<Position>().Each())
+			sum += position.x;
+		sink = sum;
+	}));
+
+	Report("View<Position> Each(f)", Measure([&]
+	{
+		float sum = 0.f;
+		registry.View<Position>().Each([&](ecs::Entity, Position& aPosition) { sum += aPosition.x; });
+		sink = sum;
+	}));
+
+	Report("View<P, V, M> entities + Get", Measure([&]
+	{
+		float sum = 0.f;
+		for (ecs::Entity entity : registry.View<Position, Velocity, Mass>())
+		{
+			Position& position = registry.Get<Position>(entity);
+			position.x += registry.Get<Velocity>(entity).x * registry.Get<Mass>(entity).m;
+			sum += position.x;
+		}
+		sink = sum;
+	}));
+
+	Report("View<P, V, M> Each()", Measure([&]
+	{
+		float sum = 0.f;
+		for (auto&& [entity, position, velocity, mass] : registry.View<Position, Velocity, Mass>().Each())
+		{
+			position.x += velocity.x * mass.m;
+			sum += position.x;
+		}
+		sink = sum;
+	}));
+
+	Report("View<P, V, M> Each(f)", Measure([&]
+	{
+		float sum = 0.f;
+		registry.View<Position, Velocity, Mass>().Each([&](ecs::Entity, Position& aPosition, Velocity& aVelocity, Mass& aMass)
+		{
+			aPosition.x += aVelocity.x * aMass.m;
+			sum += aPosition.x;
+		});
+		sink = sum;
+	}));
+
+	Report("View<P, V, M> !Frozen Each()", Measure([&]
+	{
+		float sum = 0.f;
+		for (auto&& [entity, position, velocity, mass] : registry.View<Position, Velocity, Mass>(ecs::Exclude<Frozen>()).Each())
+		{
+			position.x += velocity.x * mass.m;
+			sum += position.x;
+		}
+		sink = sum;
+	}));
+
+	Report("View<P, V, M> !Frozen Each(f)", Measure([&]
+	{
+		float sum = 0.f;
+		registry.View<Position, Velocity, Mass>(ecs::Exclude<Frozen>()).Each([&](ecs::Entity, Position& aPosition, Velocity& aVelocity, Mass& aMass)
+		{
+			aPosition.x += aVelocity.x * aMass.m;
+			sum += aPosition.x;
+		});
+		sink = sum;
+	}));
+
+	return 0;
+}